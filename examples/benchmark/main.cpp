@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <tempo.h>
+
+/**
+ * Benchmarks of Tempo, run with a real window and main loop
+ *
+ * Event wakeup latency: a worker thread posts events at random intervals while
+ * the main loop waits for events (Config::WAIT). The latency is measured from
+ * the post of the event to the call of the listener.
+ *
+ * Font atlas: the same font is needed at many sizes (e.g. zoom levels). With bitmap
+ * fonts, each size is a font in the atlas, with SDF fonts (FONT_FLAGS_SDF) a single
+ * font is scaled. The texture memory and build time of both atlas pages are compared,
+ * and the memory of all the atlases with the one they would take as RGBA.
+ *
+ * PushFont/PopFont: time of a pair, and the number of heap allocations it makes
+ * (counted by the global operator new below).
+ *
+ * Text layout: the sizes of the text cache must match ImGui::CalcTextSize, including
+ * texts with empty and trailing lines.
+ *
+ * Tweens: time of TweenEngine::update with 10k tweens, using all the easings.
+ *
+ * Lane fairness: a backlog of slow normal priority events is interleaved with low
+ * priority events in a queue with a dispatch budget. Each poll must still dispatch
+ * a low priority event.
+ */
+
+static std::atomic<size_t> allocation_count{ 0 };
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+static float percentile(std::vector<long long> values, float p) {
+    if (values.empty())
+        return 0.f;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(p * (float)(values.size() - 1));
+    return (float)values[index];
+}
+
+class MainApp : public Tempo::App {
+private:
+    static constexpr int num_wakeup_samples = 500;
+
+    Tempo::Subscription m_wakeup_subscription;
+    std::vector<long long> m_wakeup_latencies;
+    std::thread m_poster;
+    std::atomic<bool> m_stop{ false };
+
+    static constexpr const char* font_file = "fonts/Roboto/Roboto-Regular.ttf";
+    static constexpr int num_font_sizes = 13;
+    static constexpr float min_font_size = 12.f;
+    static constexpr float font_size_step = 4.f;
+
+    enum fontBenchStage {
+        FONT_BENCH_START,
+        FONT_BENCH_BITMAP,
+        FONT_BENCH_SDF,
+        FONT_BENCH_DONE
+    };
+    fontBenchStage m_font_stage = FONT_BENCH_START;
+    size_t m_font_builds = 0;
+    std::vector<Tempo::FontID> m_bitmap_fonts;
+    Tempo::FontID m_sdf_font = -1;
+    Tempo::FontAtlasStats m_bitmap_stats;
+    Tempo::FontAtlasStats m_sdf_stats;
+
+    static constexpr int num_font_pushes = 100000;
+    Tempo::FontID m_text_font = -1;
+    bool m_push_font_measured = false;
+    double m_push_font_ns = 0.;
+    size_t m_push_font_allocations = 0;
+
+    bool m_text_layout_checked = false;
+
+public:
+    virtual ~MainApp() {}
+
+    void InitializationBeforeLoop() override {
+        measure_lane_fairness();
+        measure_tweens();
+
+        m_wakeup_latencies.reserve(num_wakeup_samples);
+        m_wakeup_subscription = Tempo::EventQueue::getInstance().subscribe("bench/wakeup", [this](Tempo::Event_ptr& event) {
+            auto latency = std::chrono::system_clock::now() - event->getTime();
+            m_wakeup_latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+            if (m_wakeup_latencies.size() == num_wakeup_samples)
+                report_wakeup_latency();
+            });
+
+        m_poster = std::thread([this]() {
+            std::mt19937 generator(42);
+            std::uniform_int_distribution<int> interval(2, 20);
+            for (int i = 0; i < num_wakeup_samples && !m_stop; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(interval(generator)));
+                Tempo::EventQueue::getInstance().post(Tempo::Event_ptr(new Tempo::Event("bench/wakeup")));
+            }
+            });
+    }
+
+    /**
+     * Runs before the loop starts, the tweens are released afterwards
+     */
+    static void measure_tweens() {
+        constexpr int num_tweens = 10000;
+        constexpr int num_updates = 1000;
+        auto& engine = Tempo::TweenEngine::getInstance();
+        std::vector<Tempo::TweenHandle> tweens;
+        tweens.reserve(num_tweens);
+        for (int i = 0; i < num_tweens; i++) {
+            tweens.push_back(engine.start(0.f, 1.f, 10., (Tempo::easingType)(i % Tempo::EASING_COUNT)));
+        }
+        engine.update();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_updates; i++) {
+            engine.update();
+        }
+        auto duration = std::chrono::steady_clock::now() - start;
+        for (auto tween : tweens) {
+            engine.release(tween);
+        }
+        engine.update();
+
+        std::cout << "TweenEngine::update, " << num_tweens << " tweens" << std::endl;
+        std::cout << "  " << (double)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 1000. / num_updates
+            << " us per update" << std::endl;
+    }
+
+    /**
+     * Runs on its own queue, before the loop starts
+     */
+    static void measure_lane_fairness() {
+        constexpr int num_polls = 5;
+        Tempo::EventQueue queue("bench/fairness");
+        queue.setDispatchBudget(std::chrono::milliseconds(1));
+        int normal = 0;
+        int low = 0;
+        auto normal_subscription = queue.subscribe("bench/normal", [&normal](Tempo::Event_ptr&) {
+            normal++;
+            std::this_thread::sleep_for(std::chrono::microseconds(300));
+            });
+        auto low_subscription = queue.subscribe("bench/low", [&low](Tempo::Event_ptr&) {
+            low++;
+            });
+        for (int i = 0; i < 100; i++) {
+            queue.post(Tempo::Event_ptr(new Tempo::Event("bench/normal")));
+            if (i % 10 == 0)
+                queue.post(Tempo::Event_ptr(new Tempo::Event("bench/low", false, Tempo::Event::EVENT_PRIORITY_LOW)));
+        }
+        for (int i = 0; i < num_polls; i++) {
+            queue.pollEvents();
+        }
+        std::cout << "Lane fairness, 1 ms budget, " << num_polls << " polls" << std::endl;
+        std::cout << "  normal: " << normal << " / 100, low: " << low << " / 10"
+            << (low >= num_polls ? "" : " (low priority lane starved)") << std::endl;
+    }
+
+    void report_wakeup_latency() {
+        std::cout << "Event wakeup latency (post -> callback), " << m_wakeup_latencies.size() << " samples" << std::endl;
+        std::cout << "  p50: " << percentile(m_wakeup_latencies, 0.5f) << " us" << std::endl;
+        std::cout << "  p95: " << percentile(m_wakeup_latencies, 0.95f) << " us" << std::endl;
+        std::cout << "  p99: " << percentile(m_wakeup_latencies, 0.99f) << " us" << std::endl;
+        std::cout << "  max: " << percentile(m_wakeup_latencies, 1.f) << " us" << std::endl;
+    }
+
+    /**
+     * Adds the fonts one stage after the other, once the page of the previous stage is built
+     */
+    void update_font_benchmark() {
+        Tempo::FontAtlasStats stats = Tempo::GetFontAtlasStats();
+        switch (m_font_stage) {
+        case FONT_BENCH_START:
+            m_text_font = Tempo::AddFontFromFileTTF(font_file, 16.f).value_or(-1);
+            for (int i = 0; i < num_font_sizes; i++) {
+                auto font = Tempo::AddFontFromFileTTF(font_file, min_font_size + font_size_step * (float)i);
+                if (font.has_value())
+                    m_bitmap_fonts.push_back(font.value());
+            }
+            if (m_bitmap_fonts.empty()) {
+                std::cout << "Font atlas: cannot open " << font_file << std::endl;
+                m_font_stage = FONT_BENCH_DONE;
+                return;
+            }
+            m_font_builds = stats.builds;
+            m_font_stage = FONT_BENCH_BITMAP;
+            break;
+        case FONT_BENCH_BITMAP:
+            if (stats.builds == m_font_builds)
+                return;
+            m_bitmap_stats = stats;
+            m_sdf_font = Tempo::AddFontFromFileTTF(font_file, min_font_size, ImFontConfig{}, ImVector<ImWchar>(), false, Tempo::FONT_FLAGS_SDF).value();
+            m_font_builds = stats.builds;
+            m_font_stage = FONT_BENCH_SDF;
+            break;
+        case FONT_BENCH_SDF:
+            if (stats.builds == m_font_builds)
+                return;
+            m_sdf_stats = stats;
+            report_font_atlas();
+            // The bitmap fonts are not needed anymore, their page is destroyed
+            for (Tempo::FontID font : m_bitmap_fonts) {
+                Tempo::RemoveFont(font);
+            }
+            m_bitmap_fonts.clear();
+            m_font_stage = FONT_BENCH_DONE;
+            break;
+        case FONT_BENCH_DONE:
+            break;
+        }
+    }
+
+    void report_font_atlas() {
+        const float max_font_size = min_font_size + font_size_step * (float)(num_font_sizes - 1);
+        std::cout << "Font atlas, " << font_file << " at " << num_font_sizes << " sizes ("
+            << min_font_size << " to " << max_font_size << " px)" << std::endl;
+        std::cout << "  bitmap: " << num_font_sizes << " fonts, " << m_bitmap_stats.last_build_bytes / 1024 << " KB, "
+            << m_bitmap_stats.last_build_ms << " ms" << std::endl;
+        std::cout << "  SDF: 1 font, " << m_sdf_stats.last_build_bytes / 1024 << " KB, "
+            << m_sdf_stats.last_build_ms << " ms" << std::endl;
+        std::cout << "  all atlases: " << m_sdf_stats.texture_bytes / 1024 << " KB uploaded, "
+            << m_sdf_stats.rgba_texture_bytes / 1024 << " KB as RGBA" << std::endl;
+    }
+
+    /**
+     * Must be called inside a window, once the font is built
+     */
+    void measure_push_font() {
+        size_t allocations = allocation_count.load();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_font_pushes; i++) {
+            Tempo::PushFont(m_text_font);
+            Tempo::PopFont();
+        }
+        auto duration = std::chrono::steady_clock::now() - start;
+        m_push_font_allocations = allocation_count.load() - allocations;
+        m_push_font_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / num_font_pushes;
+        m_push_font_measured = true;
+
+        std::cout << "PushFont/PopFont, " << num_font_pushes << " pairs" << std::endl;
+        std::cout << "  " << m_push_font_ns << " ns per pair, " << m_push_font_allocations << " allocations" << std::endl;
+    }
+
+    /**
+     * Must be called inside a window
+     */
+    void check_text_layout() {
+        const char* texts[] = { "", "a", "\n", "a\n", "a\nb", "a\nb\n", "a\n\n", "\n\n" };
+        int mismatches = 0;
+        for (const char* text : texts) {
+            ImVec2 cached = Tempo::CalcTextSize(text);
+            ImVec2 expected = ImGui::CalcTextSize(text);
+            if (cached.x != expected.x || cached.y != expected.y)
+                mismatches++;
+        }
+        m_text_layout_checked = true;
+        std::cout << "Text layout, " << IM_ARRAYSIZE(texts) << " texts: "
+            << mismatches << " sizes differ from ImGui::CalcTextSize" << std::endl;
+    }
+
+    void FrameUpdate() override {
+        update_font_benchmark();
+
+        ImGui::Begin("Benchmark");
+        ImGui::Text("Event wakeup latency: %d / %d samples", (int)m_wakeup_latencies.size(), num_wakeup_samples);
+        if (!m_wakeup_latencies.empty()) {
+            ImGui::Text("p50: %.0f us, p99: %.0f us",
+                percentile(m_wakeup_latencies, 0.5f), percentile(m_wakeup_latencies, 0.99f));
+        }
+        auto stats = Tempo::EventQueue::getInstance().getStats();
+        ImGui::Text("Queue: mean latency %lld us, max latency %lld us",
+            (long long)stats.mean_latency.count(), (long long)stats.max_latency.count());
+        auto pacer_stats = Tempo::GetFramePacerStats();
+        ImGui::Text("Frames: %zu (%zu active), interval %.2f ms, jitter %.2f ms, p99 %.2f ms",
+            pacer_stats.frames, pacer_stats.active_frames, pacer_stats.mean_interval_ms,
+            pacer_stats.jitter_ms, pacer_stats.p99_interval_ms);
+
+        if (!m_text_layout_checked)
+            check_text_layout();
+
+        ImGui::Separator();
+        if (m_font_stage == FONT_BENCH_DONE && m_sdf_font != -1) {
+            ImGui::Text("Bitmap: %zu KB, %.1f ms / SDF: %zu KB, %.1f ms",
+                m_bitmap_stats.last_build_bytes / 1024, m_bitmap_stats.last_build_ms,
+                m_sdf_stats.last_build_bytes / 1024, m_sdf_stats.last_build_ms);
+            for (float scale = 1.f; scale <= 4.f; scale *= 2.f) {
+                Tempo::PushFont(m_sdf_font, scale);
+                ImGui::Text("SDF text at scale %.0f", scale);
+                Tempo::PopFont();
+            }
+            if (!m_push_font_measured && m_text_font != -1)
+                measure_push_font();
+            ImGui::Text("PushFont/PopFont: %.1f ns, %zu allocations", m_push_font_ns, m_push_font_allocations);
+        }
+        else {
+            ImGui::Text("Building the font atlases...");
+        }
+        ImGui::End();
+    }
+
+    void AfterLoop() override {
+        m_stop = true;
+        if (m_poster.joinable())
+            m_poster.join();
+        m_wakeup_subscription.reset();
+    }
+};
+
+int main() {
+    Tempo::Config config{
+        .app_name = "TempoBenchmark",
+        .app_title = "Tempo benchmark",
+    };
+    config.poll_or_wait = Tempo::Config::WAIT;
+
+    MainApp* app = new MainApp();
+    Tempo::Run(app, config);
+
+    return 0;
+}
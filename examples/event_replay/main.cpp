@@ -0,0 +1,72 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "../../src/event_trace.h"
+
+/**
+ * Replays an event trace recorded with Tempo::EventTraceRecorder
+ * (or Config::event_trace_file) through an EventQueue
+ *
+ * Usage: event_replay <trace file> [--realtime] [--no-listeners] [--budget <ms>]
+ *  --realtime      posts the events at the recorded pace (default: as fast as possible)
+ *  --no-listeners  does not simulate the recorded listeners
+ *  --budget <ms>   dispatch budget of the queue (see EventQueue::setDispatchBudget)
+ */
+
+static double to_ms(std::chrono::nanoseconds duration) {
+    return (double)duration.count() / 1e6;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [--realtime] [--no-listeners] [--budget <ms>]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    bool real_time = false;
+    bool simulate_listeners = true;
+    double budget = 0.;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--realtime") == 0)
+            real_time = true;
+        else if (std::strcmp(argv[i], "--no-listeners") == 0)
+            simulate_listeners = false;
+        else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+            budget = std::stod(argv[++i]);
+    }
+
+    std::vector<Tempo::TraceEvent> events;
+    try {
+        events = Tempo::readEventTrace(path);
+    }
+    catch (const Tempo::EventTraceException& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << events.size() << " events in " << path << std::endl;
+
+    auto summaries = Tempo::summarizeTraceListeners(events);
+    std::cout << "Hot listeners (recorded):" << std::endl;
+    for (size_t i = 0; i < summaries.size() && i < 10; i++) {
+        const auto& summary = summaries[i];
+        std::cout << "  " << summary.filter << ": " << summary.calls << " calls, total "
+            << to_ms(summary.total) << " ms, max " << to_ms(summary.max) << " ms" << std::endl;
+    }
+
+    auto& event_queue = Tempo::EventQueue::getInstance();
+    event_queue.setDispatchBudget(std::chrono::microseconds((long long)(budget * 1000.)));
+
+    Tempo::EventTraceReplayer replayer(event_queue);
+    if (simulate_listeners)
+        replayer.simulateListeners(events);
+    auto stats = replayer.replay(events, real_time);
+
+    std::cout << "Replay (" << (real_time ? "recorded pace" : "maximum speed") << "):" << std::endl;
+    std::cout << "  " << stats.events << " events, " << stats.polls << " polls" << std::endl;
+    std::cout << "  poll time: total " << to_ms(stats.total_poll_time) << " ms, max "
+        << to_ms(stats.max_poll_time) << " ms" << std::endl;
+    std::cout << "  wall time: " << to_ms(stats.wall_time) << " ms" << std::endl;
+
+    return 0;
+}
@@ -153,6 +153,23 @@
 #define GL_VERTEX_ARRAY_BINDING GL_VERTEX_ARRAY_BINDING_OES
 #endif
 
+// Tempo: single channel font atlases (GL 3.3+ / ES 3.0+), not in the stripped loader
+#ifndef GL_R8
+#define GL_R8                             0x8229
+#endif
+#ifndef GL_RED
+#define GL_RED                            0x1903
+#endif
+#ifndef GL_UNPACK_ALIGNMENT
+#define GL_UNPACK_ALIGNMENT               0x0CF5
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_R
+#define GL_TEXTURE_SWIZZLE_R              0x8E42
+#define GL_TEXTURE_SWIZZLE_G              0x8E43
+#define GL_TEXTURE_SWIZZLE_B              0x8E44
+#define GL_TEXTURE_SWIZZLE_A              0x8E45
+#endif
+
 // Desktop GL 2.0+ has glPolygonMode() which GL ES and WebGL don't have.
 #ifdef GL_POLYGON_MODE
 #define IMGUI_IMPL_HAS_POLYGON_MODE
@@ -187,6 +204,7 @@ struct ImGui_ImplOpenGL3_Data
     GLuint          ShaderHandle;
     GLint           AttribLocationTex;       // Uniforms location
     GLint           AttribLocationProjMtx;
+    GLint           AttribLocationSdf;       // Tempo: 1 when drawing a signed distance field font atlas
     GLuint          AttribLocationVtxPos;    // Vertex attributes location
     GLuint          AttribLocationVtxUV;
     GLuint          AttribLocationVtxColor;
@@ -194,6 +212,10 @@ struct ImGui_ImplOpenGL3_Data
     GLsizeiptr      VertexBufferSize;
     GLsizeiptr      IndexBufferSize;
     bool            HasClipOrigin;
+    ImVector<GLuint> SdfTextures;            // Tempo: textures of the SDF font atlases (zeroed by the memset, freed in Shutdown)
+    bool            SingleChannelFontAtlas;  // Tempo: font atlases without colors are uploaded as R8
+    bool            HasDamageRect;           // Tempo: only the damaged region is drawn (see ImGui_ImplOpenGL3_SetDamageRect)
+    ImVec4          DamageRect;
 
     ImGui_ImplOpenGL3_Data() { memset(this, 0, sizeof(*this)); }
 };
@@ -205,6 +227,27 @@ static ImGui_ImplOpenGL3_Data* ImGui_ImplOpenGL3_GetBackendData()
     return ImGui::GetCurrentContext() ? (ImGui_ImplOpenGL3_Data*)ImGui::GetIO().BackendRendererUserData : NULL;
 }
 
+// Tempo: R8 textures are sampled as (1, 1, 1, r) with a swizzle, like the RGBA atlas.
+// Texture swizzle is not available in GL < 3.3, ES 2.0 and WebGL
+static bool ImGui_ImplOpenGL3_UseSingleChannel(ImGui_ImplOpenGL3_Data* bd, ImFontAtlas* atlas)
+{
+    if (!bd->SingleChannelFontAtlas || atlas->TexPixelsUseColors)
+        return false;
+#if defined(IMGUI_IMPL_OPENGL_ES2) || defined(__EMSCRIPTEN__)
+    return false;
+#elif defined(IMGUI_IMPL_OPENGL_ES3)
+    return true;
+#else
+    return bd->GlVersion >= 330;
+#endif
+}
+
+// Tempo: textures drawn with the SDF path of the fragment shader
+static bool ImGui_ImplOpenGL3_IsSdfTexture(ImGui_ImplOpenGL3_Data* bd, GLuint texture)
+{
+    return bd->SdfTextures.contains(texture);
+}
+
 // Forward Declarations
 static void ImGui_ImplOpenGL3_InitPlatformInterface();
 static void ImGui_ImplOpenGL3_ShutdownPlatformInterface();
@@ -228,6 +271,7 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
     ImGui_ImplOpenGL3_Data* bd = IM_NEW(ImGui_ImplOpenGL3_Data)();
     io.BackendRendererUserData = (void*)bd;
     io.BackendRendererName = "imgui_impl_opengl3";
+    bd->SingleChannelFontAtlas = true;
 
     // Query for GL version (e.g. 320 for GL 3.2)
 #if !defined(IMGUI_IMPL_OPENGL_ES2)
@@ -304,6 +348,7 @@ void    ImGui_ImplOpenGL3_Shutdown()
     ImGui_ImplOpenGL3_DestroyDeviceObjects();
     io.BackendRendererName = NULL;
     io.BackendRendererUserData = NULL;
+    bd->SdfTextures.clear();
     IM_DELETE(bd);
 }
 
@@ -366,6 +411,7 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     };
     glUseProgram(bd->ShaderHandle);
     glUniform1i(bd->AttribLocationTex, 0);
+    glUniform1i(bd->AttribLocationSdf, 0);
     glUniformMatrix4fv(bd->AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
 
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
@@ -447,6 +493,9 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
     ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
     ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
 
+    // Tempo: SDF font atlases switch the fragment shader to its SDF path
+    GLint sdf = 0;
+
     // Render command lists
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
@@ -476,7 +525,10 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 // User callback, registered via ImDrawList::AddCallback()
                 // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                {
                     ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
+                    sdf = 0;
+                }
                 else
                     pcmd->UserCallback(cmd_list, pcmd);
             }
@@ -485,6 +537,13 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 // Project scissor/clipping rectangles into framebuffer space
                 ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
                 ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+                if (bd->HasDamageRect)
+                {
+                    if (clip_min.x < bd->DamageRect.x) clip_min.x = bd->DamageRect.x;
+                    if (clip_min.y < bd->DamageRect.y) clip_min.y = bd->DamageRect.y;
+                    if (clip_max.x > bd->DamageRect.z) clip_max.x = bd->DamageRect.z;
+                    if (clip_max.y > bd->DamageRect.w) clip_max.y = bd->DamageRect.w;
+                }
                 if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
                     continue;
 
@@ -492,7 +551,14 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
                 glScissor((int)clip_min.x, (int)((float)fb_height - clip_max.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y));
 
                 // Bind texture, Draw
-                glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID());
+                GLuint texture = (GLuint)(intptr_t)pcmd->GetTexID();
+                GLint texture_sdf = ImGui_ImplOpenGL3_IsSdfTexture(bd, texture) ? 1 : 0;
+                if (texture_sdf != sdf)
+                {
+                    glUniform1i(bd->AttribLocationSdf, texture_sdf);
+                    sdf = texture_sdf;
+                }
+                glBindTexture(GL_TEXTURE_2D, texture);
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
                 if (bd->GlVersion >= 320)
                     glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx)), (GLint)pcmd->VtxOffset);
@@ -539,34 +605,63 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
     (void)bd; // Not all compilation paths use this
 }
 
-bool ImGui_ImplOpenGL3_CreateFontsTexture()
+// Uploads the pixels of a font atlas to a new texture
+static GLuint ImGui_ImplOpenGL3_UploadFontAtlas(ImFontAtlas* atlas)
 {
-    ImGuiIO& io = ImGui::GetIO();
     ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
 
     // Build texture atlas
+    // Tempo: one channel when possible (4x less memory), RGBA 32-bit for color glyphs or old GL versions
     unsigned char* pixels;
     int width, height;
-    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);   // Load as RGBA 32-bit (75% of the memory is wasted, but default font is so small) because it is more likely to be compatible with user's existing shaders. If your ImTextureId represent a higher-level concept than just a GL texture id, consider calling GetTexDataAsAlpha8() instead to save on GPU memory.
+    const bool single_channel = ImGui_ImplOpenGL3_UseSingleChannel(bd, atlas);
+    if (single_channel)
+        atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+    else
+        atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
 
     // Upload texture to graphics system
+    GLuint texture;
     GLint last_texture;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-    glGenTextures(1, &bd->FontTexture);
-    glBindTexture(GL_TEXTURE_2D, bd->FontTexture);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 #ifdef GL_UNPACK_ROW_LENGTH // Not on WebGL/ES
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (single_channel)
+    {
+        GLint last_unpack_alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &last_unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, last_unpack_alignment);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_ONE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_ONE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_ONE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_RED);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
 
     // Store our identifier
-    io.Fonts->SetTexID((ImTextureID)(intptr_t)bd->FontTexture);
+    atlas->SetTexID((ImTextureID)(intptr_t)texture);
 
     // Restore state
     glBindTexture(GL_TEXTURE_2D, last_texture);
 
+    return texture;
+}
+
+bool ImGui_ImplOpenGL3_CreateFontsTexture()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    bd->FontTexture = ImGui_ImplOpenGL3_UploadFontAtlas(io.Fonts);
     return true;
 }
 
@@ -582,6 +677,50 @@ void ImGui_ImplOpenGL3_DestroyFontsTexture()
     }
 }
 
+bool ImGui_ImplOpenGL3_CreateFontAtlasTexture(ImFontAtlas* atlas, bool sdf)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    GLuint texture = ImGui_ImplOpenGL3_UploadFontAtlas(atlas);
+    if (sdf)
+        bd->SdfTextures.push_back(texture);
+    return true;
+}
+
+void ImGui_ImplOpenGL3_DestroyFontAtlasTexture(ImFontAtlas* atlas)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    GLuint texture = (GLuint)(intptr_t)atlas->TexID;
+    if (texture)
+    {
+        bd->SdfTextures.find_erase_unsorted(texture);
+        glDeleteTextures(1, &texture);
+        atlas->SetTexID(0);
+    }
+}
+
+void ImGui_ImplOpenGL3_SetSingleChannelFontAtlas(bool enabled)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    bd->SingleChannelFontAtlas = enabled;
+}
+
+void ImGui_ImplOpenGL3_SetDamageRect(const ImVec4* rect)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    bd->HasDamageRect = rect != NULL;
+    if (rect != NULL)
+        bd->DamageRect = *rect;
+}
+
+size_t ImGui_ImplOpenGL3_GetFontAtlasTextureBytes(ImFontAtlas* atlas)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    if (atlas->TexID == 0)
+        return 0;
+    const size_t bytes_per_pixel = ImGui_ImplOpenGL3_UseSingleChannel(bd, atlas) ? 1 : 4;
+    return (size_t)atlas->TexWidth * (size_t)atlas->TexHeight * bytes_per_pixel;
+}
+
 // If you get an error please report on github. You may try different GL context version or GLSL version. See GL<>GLSL version table at the top of this file.
 static bool CheckShader(GLuint handle, const char* desc)
 {
@@ -694,47 +833,74 @@ bool    ImGui_ImplOpenGL3_CreateDeviceObjects()
         "    gl_Position = ProjMtx * vec4(Position.xy,0,1);\n"
         "}\n";
 
+    // Tempo: when Sdf is set, the alpha of the texture is a signed distance field
+    // (edge at 128/255), thresholded with a width of one screen pixel
     const GLchar* fragment_shader_glsl_120 =
         "#ifdef GL_ES\n"
+        "#extension GL_OES_standard_derivatives : enable\n"
         "    precision mediump float;\n"
         "#endif\n"
         "uniform sampler2D Texture;\n"
+        "uniform int Sdf;\n"
         "varying vec2 Frag_UV;\n"
         "varying vec4 Frag_Color;\n"
         "void main()\n"
         "{\n"
-        "    gl_FragColor = Frag_Color * texture2D(Texture, Frag_UV.st);\n"
+        "    vec4 texel = texture2D(Texture, Frag_UV.st);\n"
+        "#if defined(GL_ES) && !defined(GL_OES_standard_derivatives)\n"
+        "    float width = 0.1;\n"
+        "#else\n"
+        "    float width = max(fwidth(texel.a), 0.0001);\n"
+        "#endif\n"
+        "    if (Sdf != 0)\n"
+        "        texel = vec4(1.0, 1.0, 1.0, smoothstep(0.502 - width, 0.502 + width, texel.a));\n"
+        "    gl_FragColor = Frag_Color * texel;\n"
         "}\n";
 
     const GLchar* fragment_shader_glsl_130 =
         "uniform sampler2D Texture;\n"
+        "uniform int Sdf;\n"
         "in vec2 Frag_UV;\n"
         "in vec4 Frag_Color;\n"
         "out vec4 Out_Color;\n"
         "void main()\n"
         "{\n"
-        "    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);\n"
+        "    vec4 texel = texture(Texture, Frag_UV.st);\n"
+        "    float width = max(fwidth(texel.a), 0.0001);\n"
+        "    if (Sdf != 0)\n"
+        "        texel = vec4(1.0, 1.0, 1.0, smoothstep(0.502 - width, 0.502 + width, texel.a));\n"
+        "    Out_Color = Frag_Color * texel;\n"
         "}\n";
 
     const GLchar* fragment_shader_glsl_300_es =
         "precision mediump float;\n"
         "uniform sampler2D Texture;\n"
+        "uniform int Sdf;\n"
         "in vec2 Frag_UV;\n"
         "in vec4 Frag_Color;\n"
         "layout (location = 0) out vec4 Out_Color;\n"
         "void main()\n"
         "{\n"
-        "    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);\n"
+        "    vec4 texel = texture(Texture, Frag_UV.st);\n"
+        "    float width = max(fwidth(texel.a), 0.0001);\n"
+        "    if (Sdf != 0)\n"
+        "        texel = vec4(1.0, 1.0, 1.0, smoothstep(0.502 - width, 0.502 + width, texel.a));\n"
+        "    Out_Color = Frag_Color * texel;\n"
         "}\n";
 
     const GLchar* fragment_shader_glsl_410_core =
         "in vec2 Frag_UV;\n"
         "in vec4 Frag_Color;\n"
         "uniform sampler2D Texture;\n"
+        "uniform int Sdf;\n"
         "layout (location = 0) out vec4 Out_Color;\n"
         "void main()\n"
         "{\n"
-        "    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);\n"
+        "    vec4 texel = texture(Texture, Frag_UV.st);\n"
+        "    float width = max(fwidth(texel.a), 0.0001);\n"
+        "    if (Sdf != 0)\n"
+        "        texel = vec4(1.0, 1.0, 1.0, smoothstep(0.502 - width, 0.502 + width, texel.a));\n"
+        "    Out_Color = Frag_Color * texel;\n"
         "}\n";
 
     // Select shaders matching our GLSL versions
@@ -788,6 +954,7 @@ bool    ImGui_ImplOpenGL3_CreateDeviceObjects()
 
     bd->AttribLocationTex = glGetUniformLocation(bd->ShaderHandle, "Texture");
     bd->AttribLocationProjMtx = glGetUniformLocation(bd->ShaderHandle, "ProjMtx");
+    bd->AttribLocationSdf = glGetUniformLocation(bd->ShaderHandle, "Sdf");
     bd->AttribLocationVtxPos = (GLuint)glGetAttribLocation(bd->ShaderHandle, "Position");
     bd->AttribLocationVtxUV = (GLuint)glGetAttribLocation(bd->ShaderHandle, "UV");
     bd->AttribLocationVtxColor = (GLuint)glGetAttribLocation(bd->ShaderHandle, "Color");
@@ -33,6 +33,17 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontsTexture();
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 
+// Tempo: textures of the font atlases other than io.Fonts (font atlas pages), stored in atlas->TexID
+// With sdf, the alpha of the atlas is a signed distance field (edge at 128) and is drawn with the SDF path of the shader
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateFontAtlasTexture(ImFontAtlas* atlas, bool sdf = false);
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyFontAtlasTexture(ImFontAtlas* atlas);
+// Tempo: font atlases without color glyphs are uploaded as R8 (swizzled to white + alpha) instead of RGBA
+// when the GL version allows it (GL 3.3, ES 3.0), enabled by default. Applies to the textures created afterwards
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetSingleChannelFontAtlas(bool enabled);
+IMGUI_IMPL_API size_t   ImGui_ImplOpenGL3_GetFontAtlasTextureBytes(ImFontAtlas* atlas);
+// Tempo: the draw commands are clipped to this rectangle (framebuffer pixels, origin at the top left), NULL to draw everything
+IMGUI_IMPL_API void     ImGui_ImplOpenGL3_SetDamageRect(const ImVec4* rect);
+
 // Specific OpenGL ES versions
 //#define IMGUI_IMPL_OPENGL_ES2     // Auto-detected on Emscripten
 //#define IMGUI_IMPL_OPENGL_ES3     // Auto-detected on iOS/Android
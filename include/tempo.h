@@ -18,8 +18,17 @@
 
 #include "../src/jobscheduler.h"
 #include "../src/events.h"
+#include "../src/event_channel.h"
+#include "../src/event_bridge.h"
 #include "../src/keyboard_shortcuts.h"
+#include "../src/latency.h"
+#include "../src/frame_fingerprint.h"
+#include "../src/frame_pacer.h"
+#include "../src/tween.h"
+#include "../src/deadlines.h"
+#include "../src/damage.h"
 #include "../src/text/fonts.h"
+#include "../src/text/text_cache.h"
 
 //compatibility with older versions of Visual Studio
 #if defined(_MSC_VER) && (_MSC_VER >= 1900) && !defined(IMGUI_DISABLE_WIN32_FUNCTIONS)
@@ -49,23 +58,71 @@ namespace Tempo {
         int imgui_config_flags = ImGuiConfigFlags_ViewportsEnable | ImGuiConfigFlags_DockingEnable;
 
         // GLFW poll or wait
+        // POLL renders continuously at the target frame rate. WAIT renders at the target frame
+        // rate while there is input or an animation (see FramePacer), and waits for events otherwise
         enum GLFW_events { POLL, WAIT };
         GLFW_events poll_or_wait = WAIT;
         double wait_timeout = 0.;
 
+        // Frame rate while rendering continuously, 0 means no limit (the refresh rate with vsync)
+        double target_fps = 0.;
+        // Time (in seconds) during which frames are rendered continuously after an input
+        double active_time = 0.5;
+        bool vsync = true;
+
         // Multi viewports focus behavior (see SetMultiViewportsFocusBehavior for explanation)
         bool viewports_focus_all = true;
 
         // DPI
         bool DPI_aware = true;
 
+        // Fonts are rebuilt by a worker of the JobScheduler while the previous atlas
+        // is still drawn (the first atlas is always built before the first frame)
+        bool build_fonts_in_background = true;
+
+        // The rasterized font atlas is cached in a file next to the window config
+        // file, and loaded at the next start if the fonts did not change
+        // (not when SDF or dynamic glyph fonts are used)
+        bool cache_font_atlas = true;
+
+        // Font atlases are uploaded with one channel (R8) instead of RGBA, which takes 4x
+        // less texture memory. Atlases with color glyphs (ADVANCED_TEXT) and GL versions
+        // without texture swizzle (before 3.3) always use RGBA
+        bool single_channel_font_atlas = true;
+
         // JobScheduler settings
         uint8_t worker_pool_size = 1;
+
+        // Number of key presses remembered to complete a keyboard shortcut (at most 64)
+        uint8_t shortcut_history_length = 6;
+
+        // Frames whose draw data is identical to the previous frame (e.g. idle frames
+        // woken by a timer) are not drawn nor swapped, see FrameFingerprint
+        // Textures updated in place must call InvalidateFrame to be redrawn
+        bool skip_identical_frames = false;
+
+        // Only the regions of the main window whose content changed are drawn again,
+        // in a framebuffer that persists between frames (see DamageTracker)
+        // Textures updated in place must call InvalidateFrame to be redrawn
+        bool damage_tracking = false;
+
+        // Input-to-present latency measurement (see InputLatencyTracker)
+        // The overlay shows the percentiles of the latency, and enables the measurement
+        bool measure_input_latency = false;
+        bool show_latency_overlay = false;
+
+        // Maximum time (in ms) spent each frame dispatching normal and low priority events
+        // Remaining events are carried over to the next frame. 0 means no limit
+        double event_dispatch_budget = 0.;
+
+        // If not empty, the events dispatched in the main loop are recorded in this
+        // binary trace file (see EventTraceRecorder and examples/event_replay)
+        std::string event_trace_file = "";
     };
 
     struct Animation {
-        std::chrono::time_point<std::chrono::steady_clock> tp;
-        long long int duration;
+        // Progress of the animation (see TweenEngine)
+        TweenHandle tween;
     };
 
     struct AppState {
@@ -83,10 +140,13 @@ namespace Tempo {
 
         // Relative to rendering
         bool redraw = false;
+        bool show_latency_overlay = false;
         bool vsync = true;
         std::chrono::steady_clock::time_point poll_until;
         double wait_timeout;
         bool skip_frame = false;
+        bool skip_identical_frames = false;
+        bool damage_tracking = false;
         bool run_app = true;
 
         // Animation
@@ -195,6 +255,18 @@ namespace Tempo {
      */
     void SetVSync(int interval);
 
+    /**
+     * @brief Sets the frame rate while rendering continuously (input, animations, PollUntil)
+     *
+     * @param fps frames per second, 0 means no limit (the refresh rate with vsync)
+     */
+    void SetTargetFPS(double fps);
+
+    /**
+     * @brief Returns the frame times and jitter measured by the frame pacer
+     */
+    FramePacerStats GetFramePacerStats();
+
     /**
      * @brief Returns the current DPI scaling of the main window
      *
@@ -205,6 +277,9 @@ namespace Tempo {
     /**
      * @brief Pushes a new animation, which can be identified by name
      *
+     * The animation is a linear tween from 0 to 1 (see StartTween, which avoids
+     * the lookup of the name and supports easing curves)
+     *
      * @param name of animation
      * @param duration in ms of the animation
      */
@@ -213,6 +288,9 @@ namespace Tempo {
     /**
      * @brief Get the animation progress
      *
+     * The progress is sampled once, at the start of the frame (the tweens are
+     * updated by the main loop), so it is the same during the whole frame
+     *
      * @param name of animation
      * @return float progress (between 0 and 1) of the animation
      * if there is no animation in progress, it always returns 1.
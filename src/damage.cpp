@@ -0,0 +1,245 @@
+#include "damage.h"
+#include "frame_fingerprint.h"
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+#include "imgui_impl_opengl3.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Tempo {
+    namespace {
+        constexpr uint64_t hash_seed = 0xcbf29ce484222325ULL;
+
+        bool is_empty(const ImVec4& rect) {
+            return rect.z <= rect.x || rect.w <= rect.y;
+        }
+
+        bool overlaps(const ImVec4& a, const ImVec4& b) {
+            return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+        }
+
+        ImVec4 merge(const ImVec4& a, const ImVec4& b) {
+            return ImVec4(std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w));
+        }
+
+        /*
+         * Bounds of the vertices of the draw list, inside its clip rects, in framebuffer pixels
+         */
+        ImVec4 list_bounds(const ImDrawList* list, ImVec2 offset, ImVec2 scale) {
+            ImVec4 bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const ImDrawVert& vertex : list->VtxBuffer) {
+                bounds.x = std::min(bounds.x, vertex.pos.x);
+                bounds.y = std::min(bounds.y, vertex.pos.y);
+                bounds.z = std::max(bounds.z, vertex.pos.x);
+                bounds.w = std::max(bounds.w, vertex.pos.y);
+            }
+            ImVec4 clip(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const ImDrawCmd& cmd : list->CmdBuffer) {
+                if (cmd.ElemCount > 0)
+                    clip = merge(clip, cmd.ClipRect);
+            }
+            bounds = ImVec4(std::max(bounds.x, clip.x), std::max(bounds.y, clip.y),
+                std::min(bounds.z, clip.z), std::min(bounds.w, clip.w));
+            if (is_empty(bounds))
+                return ImVec4(0.f, 0.f, 0.f, 0.f);
+            // One more pixel around, for the rounding and the antialiasing
+            return ImVec4(
+                std::floor((bounds.x - offset.x) * scale.x) - 1.f,
+                std::floor((bounds.y - offset.y) * scale.y) - 1.f,
+                std::ceil((bounds.z - offset.x) * scale.x) + 1.f,
+                std::ceil((bounds.w - offset.y) * scale.y) + 1.f);
+        }
+    }
+
+    void DamageTracker::add_damage(ImVec4 rect) {
+        rect = ImVec4(std::max(rect.x, 0.f), std::max(rect.y, 0.f),
+            std::min(rect.z, (float)width_), std::min(rect.w, (float)height_));
+        if (is_empty(rect))
+            return;
+        // Overlapping rectangles are merged, so that no pixel is drawn twice
+        for (size_t i = 0; i < damage_.size();) {
+            if (overlaps(rect, damage_[i])) {
+                rect = merge(rect, damage_[i]);
+                damage_.erase(damage_.begin() + (std::ptrdiff_t)i);
+                i = 0;
+            }
+            else {
+                i++;
+            }
+        }
+        damage_.push_back(rect);
+        if (damage_.size() > max_rects) {
+            ImVec4 bounds = damage_[0];
+            for (const ImVec4& damage : damage_) {
+                bounds = merge(bounds, damage);
+            }
+            damage_.assign(1, bounds);
+        }
+    }
+
+    bool DamageTracker::create_framebuffer(int width, int height) {
+        destroy();
+        if (width <= 0 || height <= 0)
+            return false;
+
+        GLint last_texture, last_framebuffer;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &last_framebuffer);
+
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glGenFramebuffers(1, &framebuffer_);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+        const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+        glBindTexture(GL_TEXTURE_2D, (GLuint)last_texture);
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)last_framebuffer);
+        if (!complete) {
+            destroy();
+            return false;
+        }
+        width_ = width;
+        height_ = height;
+        return true;
+    }
+
+    bool DamageTracker::compute_damage(const ImDrawData* draw_data) {
+        damage_.clear();
+        next_lists_.clear();
+        std::vector<bool> seen(lists_.size(), false);
+        bool callbacks = false;
+
+        for (int n = 0; n < draw_data->CmdListsCount; n++) {
+            const ImDrawList* list = draw_data->CmdLists[n];
+            ListState state{ list, FrameFingerprint::hashDrawList(list, hash_seed), ImVec4(0.f, 0.f, 0.f, 0.f) };
+            // User callbacks can draw anything, anywhere
+            if (state.hash == 0)
+                callbacks = true;
+
+            // The draw lists of the windows are kept by ImGui from one frame to the other
+            const ListState* previous = nullptr;
+            size_t previous_index = 0;
+            if ((size_t)n < lists_.size() && lists_[n].list == list) {
+                previous = &lists_[n];
+                previous_index = (size_t)n;
+            }
+            else {
+                for (size_t i = 0; i < lists_.size(); i++) {
+                    if (lists_[i].list == list) {
+                        previous = &lists_[i];
+                        previous_index = i;
+                        break;
+                    }
+                }
+            }
+            if (previous != nullptr)
+                seen[previous_index] = true;
+
+            // Unchanged, at the same place in the draw order
+            if (previous != nullptr && previous_index == (size_t)n && previous->hash == state.hash && state.hash != 0) {
+                state.bounds = previous->bounds;
+            }
+            else {
+                state.bounds = list_bounds(list, draw_data->DisplayPos, draw_data->FramebufferScale);
+                add_damage(state.bounds);
+                if (previous != nullptr)
+                    add_damage(previous->bounds);
+            }
+            next_lists_.push_back(state);
+        }
+        // Windows which are not drawn anymore
+        for (size_t i = 0; i < lists_.size(); i++) {
+            if (!seen[i])
+                add_damage(lists_[i].bounds);
+        }
+        std::swap(lists_, next_lists_);
+        return !callbacks;
+    }
+
+    bool DamageTracker::render(ImDrawData* draw_data, int width, int height, uint64_t seed) {
+        // Framebuffer objects and glBlitFramebuffer
+        if (!GLAD_GL_VERSION_3_0 || draw_data == nullptr)
+            return false;
+
+        bool full_redraw = full_redraw_ || seed != seed_;
+        if (framebuffer_ == 0 || width != width_ || height != height_) {
+            if (!create_framebuffer(width, height))
+                return false;
+            full_redraw = true;
+        }
+        if (!compute_damage(draw_data))
+            full_redraw = true;
+        seed_ = seed;
+        full_redraw_ = false;
+
+        float damaged_area = 0.f;
+        for (const ImVec4& rect : damage_) {
+            damaged_area += (rect.z - rect.x) * (rect.w - rect.y);
+        }
+        const float total_area = (float)width * (float)height;
+        if (damaged_area > max_damage_ratio * total_area)
+            full_redraw = true;
+
+        stats_.frames++;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+        glViewport(0, 0, width, height);
+        glClearColor(0.5, 0.5, 0.5, 0);
+        glDisable(GL_SCISSOR_TEST);
+        if (full_redraw) {
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+            stats_.last_damage_ratio = 1.f;
+        }
+        else if (damage_.empty()) {
+            stats_.unchanged_frames++;
+            stats_.last_damage_ratio = 0.f;
+        }
+        else {
+            // Each rectangle is cleared, then everything that overlaps it is drawn again
+            glEnable(GL_SCISSOR_TEST);
+            for (const ImVec4& rect : damage_) {
+                glScissor((int)rect.x, height - (int)rect.w, (int)(rect.z - rect.x), (int)(rect.w - rect.y));
+                glClear(GL_COLOR_BUFFER_BIT);
+                ImGui_ImplOpenGL3_SetDamageRect(&rect);
+                ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+            }
+            ImGui_ImplOpenGL3_SetDamageRect(nullptr);
+            glDisable(GL_SCISSOR_TEST);
+            stats_.partial_frames++;
+            stats_.last_damage_ratio = damaged_area / total_area;
+        }
+
+        // The persistent framebuffer is copied in the back buffer of the window
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return true;
+    }
+
+    void DamageTracker::destroy() {
+        if (framebuffer_ != 0)
+            glDeleteFramebuffers(1, &framebuffer_);
+        if (texture_ != 0)
+            glDeleteTextures(1, &texture_);
+        framebuffer_ = 0;
+        texture_ = 0;
+        width_ = 0;
+        height_ = 0;
+        lists_.clear();
+        full_redraw_ = true;
+    }
+
+    DamageStats GetDamageStats() {
+        return DamageTracker::getInstance().getStats();
+    }
+}
\ No newline at end of file
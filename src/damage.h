@@ -0,0 +1,119 @@
+#pragma once
+
+#include <imgui.h>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Tempo {
+    /**
+     * Frames drawn by the DamageTracker since the start
+     */
+    struct DamageStats {
+        size_t frames = 0;
+        // Frames where only the damaged regions have been drawn
+        size_t partial_frames = 0;
+        // Frames without any change, only presented
+        size_t unchanged_frames = 0;
+        // Share (0 to 1) of the framebuffer drawn in the last frame
+        float last_damage_ratio = 0.f;
+    };
+
+    /**
+     * @brief Redraws only the regions of the main window whose content changed
+     *
+     * The draw lists (one per ImGui window) are compared with the ones of the previous
+     * frame. The bounds of the lists that changed, appeared, disappeared or moved
+     * in the draw order, before and after the change, are the damaged rectangles.
+     * Only these rectangles are cleared and drawn again (the draw commands are clipped to them).
+     *
+     * The frame is drawn in a persistent framebuffer, which keeps the undamaged pixels,
+     * and is then copied in the back buffer of the window. Buffer age (EGL/GLX_EXT_buffer_age)
+     * would avoid the copy, but it is not exposed by GLFW.
+     *
+     * The whole frame is drawn when there is too much damage, at the first frame, after a resize,
+     * when the font textures change, when the draw data contains user callbacks, or after
+     * invalidate(). Without framebuffer objects (GL < 3.0), the caller must draw the frame itself.
+     *
+     * Only the main viewport is tracked, the other viewports are drawn normally
+     */
+    class DamageTracker {
+    private:
+        struct ListState {
+            const ImDrawList* list;
+            uint64_t hash;
+            ImVec4 bounds;
+        };
+        std::vector<ListState> lists_;
+        std::vector<ListState> next_lists_;
+        // Damaged rectangles of the current frame, in framebuffer pixels (origin at the top left)
+        std::vector<ImVec4> damage_;
+        bool full_redraw_ = true;
+        uint64_t seed_ = 0;
+
+        unsigned int framebuffer_ = 0;
+        unsigned int texture_ = 0;
+        int width_ = 0;
+        int height_ = 0;
+
+        DamageStats stats_;
+
+        DamageTracker() = default;
+
+        void add_damage(ImVec4 rect);
+        bool create_framebuffer(int width, int height);
+        /**
+         * Computes the damage of the frame, returns false if it must be fully drawn
+         */
+        bool compute_damage(const ImDrawData* draw_data);
+
+    public:
+        // Above this number of rectangles, they are merged in their bounding box
+        static constexpr size_t max_rects = 4;
+        // Above this share of the framebuffer, the whole frame is drawn
+        static constexpr float max_damage_ratio = 0.6f;
+
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        DamageTracker(DamageTracker const&) = delete;
+        void operator=(DamageTracker const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the DamageTracker
+         */
+        static DamageTracker& getInstance() {
+            static DamageTracker instance;
+            return instance;
+        }
+
+        /**
+         * @brief Draws the damaged regions of the main viewport, and copies the frame to the current framebuffer
+         *
+         * @param width width of the framebuffer of the window
+         * @param height height of the framebuffer of the window
+         * @param seed state outside of the draw data that changes the image (e.g. the font textures)
+         * @return false if the frame has not been drawn (framebuffer objects are not available)
+         */
+        bool render(ImDrawData* draw_data, int width, int height, uint64_t seed);
+
+        /**
+         * Forces the next frame to be fully drawn
+         */
+        void invalidate() {
+            full_redraw_ = true;
+        }
+
+        /**
+         * @brief Destroys the persistent framebuffer, before the OpenGL context is destroyed
+         */
+        void destroy();
+
+        DamageStats getStats() const {
+            return stats_;
+        }
+    };
+
+    DamageStats GetDamageStats();
+}
\ No newline at end of file
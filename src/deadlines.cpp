@@ -0,0 +1,109 @@
+#include "deadlines.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Tempo {
+    void DeadlineRegistry::setWakeupCallback(std::function<void()> callback) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        wakeup_ = std::move(callback);
+        main_thread_ = std::this_thread::get_id();
+    }
+
+    DeadlineID DeadlineRegistry::add(clock::time_point when, std::function<void()> task, clock::duration period) {
+        std::function<void()> wakeup;
+        DeadlineID id;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            id = next_id_++;
+            const bool earliest = deadlines_.empty() || when < deadlines_.begin()->first.first;
+            deadlines_.emplace(std::make_pair(when, id), Deadline{ std::move(task), std::max(period, clock::duration::zero()) });
+            times_[id] = when;
+            // The main loop may be waiting for a later deadline
+            // (from the main thread, the loop computes its wait after this call)
+            if (earliest && std::this_thread::get_id() != main_thread_)
+                wakeup = wakeup_;
+        }
+        if (wakeup)
+            wakeup();
+        return id;
+    }
+
+    bool DeadlineRegistry::cancel(DeadlineID id) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto it = times_.find(id);
+        if (it == times_.end())
+            return false;
+        deadlines_.erase(std::make_pair(it->second, id));
+        times_.erase(it);
+        return true;
+    }
+
+    bool DeadlineRegistry::isPending(DeadlineID id) const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return times_.count(id) > 0;
+    }
+
+    std::optional<DeadlineRegistry::clock::time_point> DeadlineRegistry::next() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (deadlines_.empty())
+            return std::nullopt;
+        return deadlines_.begin()->first.first;
+    }
+
+    size_t DeadlineRegistry::runDue(clock::time_point now) {
+        // The tasks are run without the lock, they can add or cancel deadlines
+        std::vector<std::function<void()>> tasks;
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            while (!deadlines_.empty() && deadlines_.begin()->first.first <= now) {
+                auto node = deadlines_.extract(deadlines_.begin());
+                const DeadlineID id = node.key().second;
+                Deadline& deadline = node.mapped();
+                if (deadline.task)
+                    tasks.push_back(deadline.task);
+                count++;
+
+                if (deadline.period > clock::duration::zero()) {
+                    clock::time_point when = node.key().first + deadline.period;
+                    if (when <= now) {
+                        // Skips the repetitions missed while the loop was busy
+                        const auto missed = (now - when) / deadline.period + 1;
+                        when += missed * deadline.period;
+                    }
+                    node.key() = std::make_pair(when, id);
+                    times_[id] = when;
+                    deadlines_.insert(std::move(node));
+                }
+                else {
+                    times_.erase(id);
+                }
+            }
+        }
+        for (auto& task : tasks) {
+            task();
+        }
+        return count;
+    }
+
+    size_t DeadlineRegistry::size() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return deadlines_.size();
+    }
+
+    DeadlineID ScheduleTask(long long delay, std::function<void()> task, long long period) {
+        return DeadlineRegistry::getInstance().add(
+            DeadlineRegistry::clock::now() + std::chrono::milliseconds(delay),
+            std::move(task),
+            std::chrono::milliseconds(period));
+    }
+
+    DeadlineID ScheduleRedraw(long long delay) {
+        return DeadlineRegistry::getInstance().add(DeadlineRegistry::clock::now() + std::chrono::milliseconds(delay));
+    }
+
+    void CancelDeadline(DeadlineID id) {
+        DeadlineRegistry::getInstance().cancel(id);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace Tempo {
+    typedef uint64_t DeadlineID;
+
+    /**
+     * @brief Times at which the main loop must render a frame, even if no event comes
+     *
+     * Each deadline can run a task on the main thread, and can repeat with a period.
+     * When idle, the main loop sleeps until the earliest deadline or the next event,
+     * whichever comes first (see FramePacer::waitForNextFrame), so nothing has to poll.
+     * Tempo registers its own deadlines (e.g. the blink of the text cursor).
+     *
+     * Deadlines can be added and cancelled from any thread. A deadline added from
+     * another thread, and earlier than all the others, wakes up the main loop.
+     * The tasks are run by the main loop, before BeforeFrameUpdate.
+     *
+     * @code{.cpp}
+     * // Refreshes the clock of the status bar every second
+     * DeadlineRegistry::getInstance().add(clock::now(), [this]() { updateClock(); }, std::chrono::seconds(1));
+     * @endcode
+     */
+    class DeadlineRegistry {
+    public:
+        using clock = std::chrono::steady_clock;
+
+    private:
+        struct Deadline {
+            std::function<void()> task;
+            clock::duration period;
+        };
+
+        // Sorted by time, then by id (the order in which they were added)
+        std::map<std::pair<clock::time_point, DeadlineID>, Deadline> deadlines_;
+        std::unordered_map<DeadlineID, clock::time_point> times_;
+        DeadlineID next_id_ = 1;
+        mutable std::mutex mutex_;
+
+        std::function<void()> wakeup_;
+        std::thread::id main_thread_;
+
+        DeadlineRegistry() = default;
+
+    public:
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        DeadlineRegistry(DeadlineRegistry const&) = delete;
+        void operator=(DeadlineRegistry const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the DeadlineRegistry
+         */
+        static DeadlineRegistry& getInstance() {
+            static DeadlineRegistry instance;
+            return instance;
+        }
+
+        /**
+         * @brief Sets the function which wakes up the main loop (e.g. glfwPostEmptyEvent)
+         * Must be called from the main thread
+         *
+         * @param callback wakeup function, nullptr to disable the wakeups
+         */
+        void setWakeupCallback(std::function<void()> callback);
+
+        /**
+         * @brief Adds a deadline
+         *
+         * @param when time at which a frame must be rendered
+         * @param task function run on the main thread at the deadline, can be empty
+         * @param period if not zero, the deadline repeats with this period (missed repetitions are skipped)
+         * @return id of the deadline, to cancel it
+         */
+        DeadlineID add(clock::time_point when, std::function<void()> task = nullptr, clock::duration period = clock::duration::zero());
+
+        /**
+         * @brief Removes the deadline, its task is not run
+         * @return false if the deadline has already passed (and does not repeat) or does not exist
+         */
+        bool cancel(DeadlineID id);
+
+        /**
+         * @return true if the deadline has not passed yet (or repeats)
+         */
+        bool isPending(DeadlineID id) const;
+
+        /**
+         * @return time of the earliest deadline, if any
+         */
+        std::optional<clock::time_point> next() const;
+
+        /**
+         * @brief Runs the tasks of the deadlines which have passed, and removes them
+         * (repeating deadlines are moved to their next time)
+         *
+         * @return number of deadlines which have passed
+         */
+        size_t runDue(clock::time_point now = clock::now());
+
+        /**
+         * @return number of pending deadlines
+         */
+        size_t size() const;
+    };
+
+    /**
+     * @brief Runs a task on the main thread after a delay (or repeatedly), the main loop
+     * wakes up for it. Can be called from any thread
+     *
+     * @param delay in ms
+     * @param task function to run
+     * @param period in ms, 0 if the task runs once
+     * @return id of the deadline (see CancelDeadline)
+     */
+    DeadlineID ScheduleTask(long long delay, std::function<void()> task, long long period = 0);
+
+    /**
+     * @brief Renders a frame after the delay (in ms), even if no event comes
+     * Can be called from any thread
+     */
+    DeadlineID ScheduleRedraw(long long delay);
+
+    /**
+     * @brief Cancels a task or redraw scheduled with ScheduleTask or ScheduleRedraw
+     */
+    void CancelDeadline(DeadlineID id);
+}
\ No newline at end of file
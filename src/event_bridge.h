@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "events.h"
+
+namespace Tempo {
+    /**
+     * @brief Forwards the events of some topics from one bus to another
+     *
+     * The bridge listens to the source bus, and posts each corresponding event
+     * to the destination bus, where it is dispatched the next time the destination
+     * is polled (or by its dispatch thread). The event is shared between both
+     * buses, so forwarding does not copy it.
+     *
+     * @code{.cpp}
+     * // Only the alerts of the telemetry bus reach the UI
+     * EventBridge alerts(telemetry_bus, EventQueue::getInstance(), "telemetry/alert*");
+     * @endcode
+     *
+     * @note Bridges must not form a cycle on the same topics, otherwise
+     * the events are forwarded forever
+     */
+    class EventBridge {
+    private:
+        EventQueue& to_;
+        Subscription subscription_;
+
+    public:
+        /**
+         * Opens a bridge between two buses
+         * @param from source bus
+         * @param to destination bus
+         * @param filter topics to forward (see EventQueue::isListener)
+         */
+        EventBridge(EventQueue& from, EventQueue& to, std::string filter) : to_(to) {
+            subscription_ = from.subscribe(std::move(filter), [this](Event_ptr& event) {
+                to_.post(event);
+                });
+        }
+
+        EventBridge(EventBridge const&) = delete;
+        void operator=(EventBridge const&) = delete;
+
+        /**
+         * @brief Stops forwarding the events
+         * Once the function returns, no more events are forwarded
+         */
+        void close() {
+            subscription_.reset();
+        }
+
+        /**
+         * @return true if the bridge has not been closed
+         */
+        bool isOpen() const {
+            return subscription_.isActive();
+        }
+    };
+}
\ No newline at end of file
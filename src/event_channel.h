@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "events.h"
+
+namespace Tempo {
+    /**
+     * Listener of a typed channel
+     * The callback receives a const reference to the event, which is only
+     * valid for the duration of the callback
+     */
+    template <typename T>
+    struct TypedListener {
+        std::string filter = "*";
+        std::function<void(const T&)> callback;
+    };
+
+    /**
+     * Default settings of the channel of events of type T
+     * Can be specialized to change the priority lane of a type of events, e.g.
+     * @code{.cpp}
+     * template <> struct EventChannelTraits<MyTelemetryEvent> {
+     *     static constexpr Event::eventPriority priority = Event::EVENT_PRIORITY_LOW;
+     * };
+     * @endcode
+     */
+    template <typename T>
+    struct EventChannelTraits {
+        static constexpr Event::eventPriority priority = Event::EVENT_PRIORITY_NORMAL;
+    };
+
+    /**
+     * @brief The EventChannel is a thread-safe channel that only transports
+     * events of type T (which should inherit from Event)\n
+     *
+     * Contrary to the EventQueue, the events are stored by value in the channel:
+     * posting an event does not allocate a shared_ptr, and the storage of the
+     * events is reused from one poll to the next. Listeners receive a `const T&`,
+     * so there is no need to cast the event back to its real type.
+     *
+     * The channel is registered to an EventQueue, and is polled each time
+     * EventQueue::pollEvents() is called, along with the other events of the same
+     * priority. Filters work the same way as for the EventQueue (see EventQueue::isListener).
+     *
+     * @code{.cpp}
+     * auto& channel = EventChannel<LogEvent>::getInstance();
+     * TypedListener<LogEvent> listener{
+     *     .filter = "log*",
+     *     .callback = [] (const LogEvent& event) {
+     *         std::cout << event.getMessage() << std::endl;
+     *     },
+     * };
+     * channel.subscribe(&listener);
+     *
+     * // Arguments are forwarded to the constructor of LogEvent
+     * channel.post("debug", "Hello world");
+     *
+     * EventQueue::getInstance().pollEvents();
+     * channel.unsubscribe(&listener);
+     * @endcode
+     */
+    template <typename T>
+    class EventChannel : public EventChannelBase {
+    private:
+        // Events posted since the last poll, and events being dispatched
+        // Both vectors are swapped at each poll, so that their capacity is reused
+        std::vector<T> pending_;
+        std::vector<T> dispatching_;
+        // Events of dispatching_ that have not been dispatched yet because of the budget
+        size_t dispatch_index_ = 0;
+        std::atomic<size_t> remaining_{ 0 };
+        mutable std::mutex pending_mutex_;
+        Event::eventPriority priority_;
+
+        ListenerList<TypedListener<T>> listeners_;
+        bool is_polling_ = false;
+
+        EventQueue& event_queue_;
+
+    public:
+        /**
+         * Creates a channel which is polled by the given event queue
+         * @param event_queue queue that will poll the channel
+         * @param priority priority lane of the channel in the event queue
+         */
+        explicit EventChannel(EventQueue& event_queue = EventQueue::getInstance(), Event::eventPriority priority = EventChannelTraits<T>::priority)
+            : priority_(priority), event_queue_(event_queue) {
+            event_queue_.addChannel(this);
+        }
+
+        ~EventChannel() override {
+            event_queue_.removeChannel(this);
+        }
+
+        EventChannel(EventChannel const&) = delete;
+        void operator=(EventChannel const&) = delete;
+
+        /**
+         * @return default channel for events of type T, polled by EventQueue::getInstance()
+         */
+        static EventChannel& getInstance() {
+            static EventChannel instance;
+            return instance;
+        }
+
+        /**
+         * @brief Adds a listener which will observe the channel
+         * It is not possible to add the same listener multiple time
+         *
+         * It is up to the user to manage the pointer of the listener,
+         * and to unsubscribe before freeing it
+         * @param listener pointer to the TypedListener
+         */
+        void subscribe(TypedListener<T>* listener) {
+            listeners_.add(listener);
+        }
+
+        /**
+         * @brief Adds a listener owned by the channel
+         *
+         * @param filter filter of the events (see EventQueue::isListener)
+         * @param callback function called for each corresponding event
+         * @return handle which unsubscribes the listener when destroyed
+         */
+        Subscription subscribe(std::string filter, std::function<void(const T&)> callback) {
+            auto listener = std::make_shared<TypedListener<T>>();
+            listener->filter = std::move(filter);
+            listener->callback = std::move(callback);
+            TypedListener<T>* listener_ptr = listener.get();
+            listeners_.add(listener_ptr, std::move(listener));
+            return Subscription([this, listener_ptr]() { unsubscribe(listener_ptr); });
+        }
+
+        /**
+         * @brief Removes the listener from the channel
+         * Once the function returns, the listener is guaranteed not to be called anymore
+         *
+         * @param listener pointer to the TypedListener
+         */
+        void unsubscribe(TypedListener<T>* listener) {
+            listeners_.remove(listener);
+        }
+
+        /**
+         * Constructs an event in place in the channel
+         * @param args arguments forwarded to the constructor of T
+         */
+        template <typename... Args>
+        void post(Args&&... args) {
+            std::lock_guard<std::mutex> guard(pending_mutex_);
+            pending_.emplace_back(std::forward<Args>(args)...);
+            remaining_++;
+            // Under the lock, because the event can be swapped out by a poll right after
+            event_queue_.requestWakeup(pending_.back().getName());
+        }
+
+        /**
+         * Dispatches the events posted to the channel until the deadline is passed
+         * Is called by EventQueue::pollEvents()
+         */
+        bool pollEvents(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(), DispatchLatency* latency = nullptr) override {
+            typename ListenerList<TypedListener<T>>::DispatchGuard guard(listeners_);
+            // Nested polls (from a callback) are ignored, the events are dispatched by the outer poll
+            if (is_polling_)
+                return false;
+            if (dispatch_index_ >= dispatching_.size()) {
+                // Keeps the capacity for the next poll
+                dispatching_.clear();
+                dispatch_index_ = 0;
+                std::lock_guard<std::mutex> pending_guard(pending_mutex_);
+                if (pending_.empty())
+                    return true;
+                std::swap(pending_, dispatching_);
+            }
+            is_polling_ = true;
+            bool is_first = true;
+            while (dispatch_index_ < dispatching_.size()) {
+                if (!is_first && std::chrono::steady_clock::now() >= deadline)
+                    break;
+                is_first = false;
+                const T& event = dispatching_[dispatch_index_++];
+                remaining_--;
+                if (latency)
+                    latency->add(event.getTime());
+                auto snapshot = listeners_.snapshot();
+                auto observer = event_queue_.getObserver();
+                if (observer) {
+                    using clock = std::chrono::steady_clock;
+                    const auto start = clock::now();
+                    observer->onDispatchBegin(event);
+                    for (const auto& entry : *snapshot) {
+                        typename ListenerList<TypedListener<T>>::CallGuard call(*entry);
+                        if (call.isActive() && EventQueue::isListener(entry->listener->filter, event.getName())) {
+                            const auto listener_start = clock::now();
+                            entry->listener->callback(event);
+                            observer->onListenerCalled(event, entry->listener->filter, clock::now() - listener_start);
+                        }
+                    }
+                    observer->onDispatchEnd(event, clock::now() - start);
+                }
+                else {
+                    for (const auto& entry : *snapshot) {
+                        typename ListenerList<TypedListener<T>>::CallGuard call(*entry);
+                        if (call.isActive() && EventQueue::isListener(entry->listener->filter, event.getName()))
+                            entry->listener->callback(event);
+                    }
+                }
+            }
+            is_polling_ = false;
+            return dispatch_index_ >= dispatching_.size();
+        }
+
+        size_t getQueueDepth() const override {
+            return remaining_.load();
+        }
+
+        Event::eventPriority getPriority() const override {
+            return priority_;
+        }
+
+        /**
+         * @return number of listeners currently listening to the given event name
+         */
+        size_t getNumSubscribers(const std::string& event_name) {
+            auto snapshot = listeners_.snapshot();
+            size_t count = 0;
+            for (const auto& entry : *snapshot) {
+                if (EventQueue::isListener(entry->listener->filter, event_name))
+                    count++;
+            }
+            return count;
+        }
+    };
+}
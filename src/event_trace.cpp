@@ -0,0 +1,398 @@
+#include "event_trace.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+namespace Tempo {
+    namespace {
+        constexpr char trace_magic[8] = { 'T', 'E', 'M', 'P', 'O', 'T', 'R', 'C' };
+        constexpr uint32_t trace_version = 2;
+        // The writer thread is notified once the buffer reaches this size
+        constexpr size_t flush_size = 64 * 1024;
+
+        enum recordType : uint8_t {
+            RECORD_NAME = 1,
+            RECORD_EVENT = 2,
+            RECORD_LISTENER = 3,
+            RECORD_END = 4
+        };
+
+        template <typename T>
+        void put(std::vector<char>& buffer, T value) {
+            auto unsigned_value = (uint64_t)value;
+            for (size_t i = 0; i < sizeof(T); i++) {
+                buffer.push_back((char)((unsigned_value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        uint32_t saturate_ns(std::chrono::nanoseconds duration) {
+            auto count = duration.count();
+            if (count < 0)
+                return 0;
+            if (count > (long long)std::numeric_limits<uint32_t>::max())
+                return std::numeric_limits<uint32_t>::max();
+            return (uint32_t)count;
+        }
+
+        class TraceReader {
+        private:
+            const std::vector<char>& data_;
+            size_t pos_ = 0;
+
+        public:
+            explicit TraceReader(const std::vector<char>& data) : data_(data) {}
+
+            bool atEnd() const { return pos_ >= data_.size(); }
+
+            template <typename T>
+            T get() {
+                if (pos_ + sizeof(T) > data_.size())
+                    throw EventTraceException("Trace file is truncated");
+                uint64_t value = 0;
+                for (size_t i = 0; i < sizeof(T); i++) {
+                    value |= (uint64_t)(uint8_t)data_[pos_ + i] << (8 * i);
+                }
+                pos_ += sizeof(T);
+                return (T)value;
+            }
+
+            std::string getString(size_t length) {
+                if (pos_ + length > data_.size())
+                    throw EventTraceException("Trace file is truncated");
+                std::string str(data_.data() + pos_, length);
+                pos_ += length;
+                return str;
+            }
+        };
+    }
+
+    /*
+     * Observer that serializes the records in memory
+     */
+    class EventTraceRecorder::Observer : public EventQueueObserver {
+    public:
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<char> buffer;
+        bool stop = false;
+
+        std::unordered_map<std::string, uint32_t> string_ids;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint32_t next_dispatch_id = 0;
+
+        /**
+         * Dispatches in progress on the current thread, innermost last
+         * A listener can dispatch another event (or another observed bus) before returning,
+         * so the records of a dispatch are identified by its id rather than by their order
+         */
+        static std::vector<std::pair<const Observer*, uint32_t>>& open_dispatches() {
+            thread_local std::vector<std::pair<const Observer*, uint32_t>> dispatches;
+            return dispatches;
+        }
+
+        uint32_t current_dispatch() const {
+            const auto& dispatches = open_dispatches();
+            for (auto it = dispatches.rbegin(); it != dispatches.rend(); it++) {
+                if (it->first == this)
+                    return it->second;
+            }
+            return std::numeric_limits<uint32_t>::max();
+        }
+
+        // Should be called with the mutex held
+        uint32_t string_id(const std::string& str) {
+            auto it = string_ids.find(str);
+            if (it != string_ids.end())
+                return it->second;
+            uint32_t id = (uint32_t)string_ids.size();
+            string_ids.emplace(str, id);
+            uint16_t length = (uint16_t)std::min(str.size(), (size_t)std::numeric_limits<uint16_t>::max());
+            put<uint8_t>(buffer, RECORD_NAME);
+            put<uint32_t>(buffer, id);
+            put<uint16_t>(buffer, length);
+            buffer.insert(buffer.end(), str.begin(), str.begin() + length);
+            return id;
+        }
+
+        void onDispatchBegin(const Event& event) override {
+            const auto posted_at = std::chrono::duration_cast<std::chrono::microseconds>(event.getTime().time_since_epoch()).count();
+            const auto dispatched_at = (std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> guard(mutex);
+            const uint32_t dispatch_id = next_dispatch_id++;
+            open_dispatches().emplace_back(this, dispatch_id);
+            if (stop)
+                return;
+            uint32_t name_id = string_id(event.getName());
+            put<uint8_t>(buffer, RECORD_EVENT);
+            put<uint32_t>(buffer, dispatch_id);
+            put<uint32_t>(buffer, name_id);
+            put<int64_t>(buffer, (int64_t)posted_at);
+            put<int64_t>(buffer, (int64_t)dispatched_at);
+            put<uint32_t>(buffer, (uint32_t)event.getSize());
+            put<uint8_t>(buffer, (uint8_t)event.getPriority());
+            put<uint8_t>(buffer, event.isAcknowledgable() ? 1 : 0);
+        }
+
+        void onListenerCalled(const Event&, const std::string& filter, std::chrono::nanoseconds duration) override {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (stop)
+                return;
+            uint32_t filter_id = string_id(filter);
+            put<uint8_t>(buffer, RECORD_LISTENER);
+            put<uint32_t>(buffer, current_dispatch());
+            put<uint32_t>(buffer, filter_id);
+            put<uint32_t>(buffer, saturate_ns(duration));
+        }
+
+        void onDispatchEnd(const Event&, std::chrono::nanoseconds duration) override {
+            const uint32_t dispatch_id = current_dispatch();
+            auto& dispatches = open_dispatches();
+            for (auto it = dispatches.rbegin(); it != dispatches.rend(); it++) {
+                if (it->first == this) {
+                    dispatches.erase(std::next(it).base());
+                    break;
+                }
+            }
+            std::lock_guard<std::mutex> guard(mutex);
+            if (stop)
+                return;
+            put<uint8_t>(buffer, RECORD_END);
+            put<uint32_t>(buffer, dispatch_id);
+            put<uint32_t>(buffer, saturate_ns(duration));
+            if (buffer.size() >= flush_size)
+                cv.notify_one();
+        }
+    };
+
+    /*
+     * Implementation of EventTraceRecorder
+     */
+    EventTraceRecorder::EventTraceRecorder(EventQueue& event_queue, const std::string& path)
+        : event_queue_(event_queue), observer_(std::make_shared<Observer>()) {
+        file_.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!file_.good()) {
+            throw EventTraceException("Cannot open trace file " + path);
+        }
+        std::vector<char> header(trace_magic, trace_magic + sizeof(trace_magic));
+        put<uint32_t>(header, trace_version);
+        file_.write(header.data(), (std::streamsize)header.size());
+
+        writer_ = std::thread(&EventTraceRecorder::writer_fct, this);
+        event_queue_.setObserver(observer_);
+    }
+
+    EventTraceRecorder::~EventTraceRecorder() {
+        stop();
+    }
+
+    void EventTraceRecorder::writer_fct() {
+        std::vector<char> to_write;
+        while (true) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(observer_->mutex);
+                observer_->cv.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                    return observer_->stop || observer_->buffer.size() >= flush_size;
+                    });
+                std::swap(to_write, observer_->buffer);
+                stop = observer_->stop;
+            }
+            if (!to_write.empty()) {
+                file_.write(to_write.data(), (std::streamsize)to_write.size());
+                file_.flush();
+                to_write.clear();
+            }
+            if (stop)
+                break;
+        }
+    }
+
+    void EventTraceRecorder::stop() {
+        if (!writer_.joinable())
+            return;
+        if (event_queue_.getObserver() == observer_)
+            event_queue_.setObserver(nullptr);
+        {
+            std::lock_guard<std::mutex> guard(observer_->mutex);
+            observer_->stop = true;
+        }
+        observer_->cv.notify_one();
+        writer_.join();
+        file_.close();
+    }
+
+    bool EventTraceRecorder::isRecording() const {
+        return writer_.joinable();
+    }
+
+    /*
+     * Reading and analysis of the traces
+     */
+    std::vector<TraceEvent> readEventTrace(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.good()) {
+            throw EventTraceException("Cannot open trace file " + path);
+        }
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (data.size() < sizeof(trace_magic) || std::memcmp(data.data(), trace_magic, sizeof(trace_magic)) != 0) {
+            throw EventTraceException(path + " is not an event trace");
+        }
+        TraceReader reader(data);
+        reader.getString(sizeof(trace_magic));
+        if (reader.get<uint32_t>() != trace_version) {
+            throw EventTraceException("Unsupported trace version in " + path);
+        }
+
+        std::vector<std::string> strings;
+        std::vector<TraceEvent> events;
+        // Dispatches whose end has not been read yet, by id
+        std::unordered_map<uint32_t, size_t> open_events;
+        auto get_event = [&open_events, &events](uint32_t id) -> TraceEvent& {
+            auto it = open_events.find(id);
+            if (it == open_events.end())
+                throw EventTraceException("Trace file references an unknown dispatch");
+            return events[it->second];
+        };
+        auto get_string = [&strings](uint32_t id) -> const std::string& {
+            if (id >= strings.size())
+                throw EventTraceException("Trace file references an unknown name");
+            return strings[id];
+        };
+
+        while (!reader.atEnd()) {
+            auto type = reader.get<uint8_t>();
+            switch (type) {
+            case RECORD_NAME: {
+                auto id = reader.get<uint32_t>();
+                auto length = reader.get<uint16_t>();
+                if (id != strings.size())
+                    throw EventTraceException("Trace file has an invalid string table");
+                strings.push_back(reader.getString(length));
+                break;
+            }
+            case RECORD_EVENT: {
+                const auto dispatch_id = reader.get<uint32_t>();
+                TraceEvent event;
+                event.name = get_string(reader.get<uint32_t>());
+                event.posted_at = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(reader.get<int64_t>())));
+                event.dispatched_at = std::chrono::nanoseconds(reader.get<int64_t>());
+                event.size = reader.get<uint32_t>();
+                auto priority = reader.get<uint8_t>();
+                event.priority = priority < Event::EVENT_PRIORITY_COUNT ? (Event::eventPriority)priority : Event::EVENT_PRIORITY_NORMAL;
+                event.acknowledgable = reader.get<uint8_t>() != 0;
+                open_events[dispatch_id] = events.size();
+                events.push_back(std::move(event));
+                break;
+            }
+            case RECORD_LISTENER: {
+                const auto dispatch_id = reader.get<uint32_t>();
+                TraceListenerCall call;
+                call.filter = get_string(reader.get<uint32_t>());
+                call.duration = std::chrono::nanoseconds(reader.get<uint32_t>());
+                get_event(dispatch_id).listeners.push_back(std::move(call));
+                break;
+            }
+            case RECORD_END: {
+                const auto dispatch_id = reader.get<uint32_t>();
+                auto duration = std::chrono::nanoseconds(reader.get<uint32_t>());
+                get_event(dispatch_id).dispatch_duration = duration;
+                open_events.erase(dispatch_id);
+                break;
+            }
+            default:
+                throw EventTraceException("Trace file contains an unknown record");
+            }
+        }
+        return events;
+    }
+
+    std::vector<TraceListenerSummary> summarizeTraceListeners(const std::vector<TraceEvent>& events) {
+        std::map<std::string, TraceListenerSummary> summaries;
+        for (const auto& event : events) {
+            for (const auto& call : event.listeners) {
+                auto& summary = summaries[call.filter];
+                summary.filter = call.filter;
+                summary.calls++;
+                summary.total += call.duration;
+                if (call.duration > summary.max)
+                    summary.max = call.duration;
+            }
+        }
+        std::vector<TraceListenerSummary> result;
+        result.reserve(summaries.size());
+        for (auto& pair : summaries) {
+            result.push_back(std::move(pair.second));
+        }
+        std::sort(result.begin(), result.end(), [](const TraceListenerSummary& lhs, const TraceListenerSummary& rhs) {
+            return lhs.total > rhs.total;
+            });
+        return result;
+    }
+
+    /*
+     * Implementation of EventTraceReplayer
+     */
+    void EventTraceReplayer::simulateListeners(const std::vector<TraceEvent>& events) {
+        for (const auto& summary : summarizeTraceListeners(events)) {
+            auto mean = summary.total / (long long)summary.calls;
+            synthetic_listeners_.push_back(event_queue_.subscribe(summary.filter, [mean](Event_ptr&) {
+                auto end = std::chrono::steady_clock::now() + mean;
+                while (std::chrono::steady_clock::now() < end) {}
+                }));
+        }
+    }
+
+    TraceReplayStats EventTraceReplayer::replay(const std::vector<TraceEvent>& events, bool real_time) {
+        using clock = std::chrono::steady_clock;
+        TraceReplayStats stats;
+
+        auto poll = [this, &stats]() {
+            auto start = clock::now();
+            event_queue_.pollEvents();
+            auto duration = clock::now() - start;
+            stats.polls++;
+            stats.total_poll_time += duration;
+            if (duration > stats.max_poll_time)
+                stats.max_poll_time = duration;
+        };
+        auto post = [this, &stats](const TraceEvent& event) {
+            event_queue_.post(MakeEvent<Event>(event.name, event.acknowledgable, event.priority));
+            stats.events++;
+        };
+
+        const auto start = clock::now();
+        if (real_time && !events.empty()) {
+            const auto origin = events.front().posted_at;
+            size_t i = 0;
+            while (i < events.size()) {
+                // Post all the events that are due, then poll them
+                auto now = clock::now();
+                while (i < events.size() && start + (events[i].posted_at - origin) <= now) {
+                    post(events[i]);
+                    i++;
+                }
+                poll();
+                if (i < events.size())
+                    std::this_thread::sleep_until(start + (events[i].posted_at - origin));
+            }
+        }
+        else {
+            for (const auto& event : events) {
+                post(event);
+            }
+        }
+        // Events can be carried over because of the dispatch budget
+        while (event_queue_.getQueueDepth() > 0) {
+            poll();
+        }
+        stats.wall_time = clock::now() - start;
+        return stats;
+    }
+}
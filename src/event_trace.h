@@ -0,0 +1,177 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "events.h"
+
+namespace Tempo {
+    /**
+     * Exceptions related to the event traces (e.g. file cannot be opened or is corrupted)
+     */
+    class EventTraceException : public std::exception {
+    private:
+        std::string what_;
+
+    public:
+        explicit EventTraceException(std::string what) : what_(std::move(what)) {}
+        const char* what() const noexcept override {
+            return what_.c_str();
+        }
+    };
+
+    /**
+     * Listener that has been called for a traced event
+     */
+    struct TraceListenerCall {
+        std::string filter;
+        std::chrono::nanoseconds duration{ 0 };
+    };
+
+    /**
+     * Event read from a trace file
+     */
+    struct TraceEvent {
+        std::string name;
+        // Time at which the event was posted (Event::getTime())
+        std::chrono::system_clock::time_point posted_at;
+        // Time of the dispatch, relative to the beginning of the recording
+        std::chrono::nanoseconds dispatched_at{ 0 };
+        std::chrono::nanoseconds dispatch_duration{ 0 };
+        uint32_t size = 0;
+        Event::eventPriority priority = Event::EVENT_PRIORITY_NORMAL;
+        bool acknowledgable = false;
+        std::vector<TraceListenerCall> listeners;
+    };
+
+    /**
+     * @brief Records the events dispatched by an EventQueue (and its channels) in a binary trace file
+     *
+     * For each dispatched event, the trace contains its name, the time at which it was posted,
+     * its size, and the listeners that have been called with the duration of their callback.
+     *
+     * The records are serialized in memory on the dispatching thread, and written
+     * to the file by a background thread.
+     *
+     * File format (little endian):
+     *  - header: "TEMPOTRC", u32 version
+     *  - records, starting with a u8 type:
+     *    - NAME: u32 id, u16 length, characters (string table for event names and filters)
+     *    - EVENT: u32 dispatch id, u32 name id, i64 posted at (us since epoch), i64 dispatched at
+     *      (ns since the beginning of the recording), u32 size, u8 priority, u8 acknowledgable
+     *    - LISTENER: u32 dispatch id, u32 filter id, u32 duration (ns)
+     *    - END: u32 dispatch id, u32 duration of the dispatch (ns)
+     *  The records of nested dispatches (an event dispatched from a listener, or
+     *  several observed buses) interleave, the dispatch id tells them apart
+     *
+     * @code{.cpp}
+     * EventTraceRecorder recorder(EventQueue::getInstance(), "session.trace");
+     * // ... the trace is written until the recorder is stopped or destroyed
+     * @endcode
+     */
+    class EventTraceRecorder {
+    private:
+        class Observer;
+
+        EventQueue& event_queue_;
+        std::shared_ptr<Observer> observer_;
+        std::ofstream file_;
+        std::thread writer_;
+
+        void writer_fct();
+
+    public:
+        /**
+         * Starts recording the given event queue
+         * @param event_queue queue to record
+         * @param path path of the trace file (overwritten)
+         * @throws EventTraceException if the file cannot be opened
+         */
+        EventTraceRecorder(EventQueue& event_queue, const std::string& path);
+        ~EventTraceRecorder();
+
+        EventTraceRecorder(EventTraceRecorder const&) = delete;
+        void operator=(EventTraceRecorder const&) = delete;
+
+        /**
+         * Stops the recording and flushes the remaining records to the file
+         */
+        void stop();
+
+        /**
+         * @return true if the recorder has not been stopped
+         */
+        bool isRecording() const;
+    };
+
+    /**
+     * Reads all the events of a trace file
+     * @param path path of the trace file
+     * @throws EventTraceException if the file cannot be read or is not a trace
+     */
+    std::vector<TraceEvent> readEventTrace(const std::string& path);
+
+    /**
+     * Cumulated cost of the listeners with the same filter in a trace
+     */
+    struct TraceListenerSummary {
+        std::string filter;
+        size_t calls = 0;
+        std::chrono::nanoseconds total{ 0 };
+        std::chrono::nanoseconds max{ 0 };
+    };
+
+    /**
+     * @return the listeners of the trace, sorted from the most to the least expensive
+     */
+    std::vector<TraceListenerSummary> summarizeTraceListeners(const std::vector<TraceEvent>& events);
+
+    /**
+     * Results of a replay
+     */
+    struct TraceReplayStats {
+        size_t events = 0;
+        size_t polls = 0;
+        std::chrono::nanoseconds total_poll_time{ 0 };
+        std::chrono::nanoseconds max_poll_time{ 0 };
+        std::chrono::nanoseconds wall_time{ 0 };
+    };
+
+    /**
+     * @brief Feeds the events of a trace back through an EventQueue
+     *
+     * The events are re-posted as plain Events (same name, priority and acknowledgable flag).
+     * Optionally, synthetic listeners reproduce the recorded listeners: one listener per
+     * recorded filter, which spins for the mean recorded duration of its callback.
+     */
+    class EventTraceReplayer {
+    private:
+        EventQueue& event_queue_;
+        std::vector<Subscription> synthetic_listeners_;
+
+    public:
+        explicit EventTraceReplayer(EventQueue& event_queue) : event_queue_(event_queue) {}
+
+        EventTraceReplayer(EventTraceReplayer const&) = delete;
+        void operator=(EventTraceReplayer const&) = delete;
+
+        /**
+         * Subscribes synthetic listeners reproducing the cost of the recorded listeners
+         */
+        void simulateListeners(const std::vector<TraceEvent>& events);
+
+        /**
+         * Replays the events
+         * @param events events read with readEventTrace
+         * @param real_time if true, the events are posted at the recorded pace and polled
+         * as they arrive, otherwise they are all posted then polled as fast as possible
+         */
+        TraceReplayStats replay(const std::vector<TraceEvent>& events, bool real_time);
+    };
+}
@@ -1,5 +1,7 @@
 #include "events.h"
 
+#include <algorithm>
+#include <cassert>
 #include <exception>
 #include <iostream>
 #include <set>
@@ -23,27 +25,102 @@ namespace Tempo {
     /*
      * Implementations of EventQueue
      */
-    void EventQueue::subscribe(Listener* listener) {
-        std::lock_guard<std::recursive_mutex> guard(listeners_mutex_);
-        if (listeners_.find(listener) == listeners_.end())
-            listeners_.insert(listener);
+    EventQueue::EventQueue(std::string name) : name_(std::move(name)) {}
+
+    EventQueue::~EventQueue() {
+        // A destructor must not throw: destroying the bus from one of its listeners is a bug,
+        // the dispatch thread is left to exit on its own
+        if (!stop_dispatch_thread()) {
+            assert(false && "An EventQueue cannot be destroyed from a listener of its dispatch thread");
+            std::lock_guard<std::mutex> guard(dispatch_thread_mutex_);
+            dispatch_thread_stop_ = true;
+            dispatch_thread_.detach();
+        }
     }
 
-    void EventQueue::unsubscribe(Listener* listener) {
-        bool has_found = false;
+    void EventQueue::startDispatchThread() {
+        std::lock_guard<std::mutex> guard(dispatch_thread_mutex_);
+        if (dispatch_thread_.joinable())
+            return;
+        dispatch_thread_stop_ = false;
+        // Events posted before the start are dispatched right away
+        dispatch_thread_notified_ = true;
+        has_dispatch_thread_.store(true);
+        dispatch_thread_ = std::thread(&EventQueue::dispatch_thread_fct, this);
+    }
+
+    void EventQueue::stopDispatchThread() {
+        if (!stop_dispatch_thread())
+            throw EventQueueException("The dispatch thread cannot be stopped from a listener of its bus");
+    }
+
+    bool EventQueue::stop_dispatch_thread() noexcept {
+        std::thread thread;
         {
-            std::lock_guard<std::recursive_mutex> guard(listeners_mutex_);
-            for (auto it : listeners_) {
-                if (it == listener) {
-                    has_found = true;
-                    break;
-                }
+            std::lock_guard<std::mutex> guard(dispatch_thread_mutex_);
+            if (!dispatch_thread_.joinable())
+                return true;
+            if (dispatch_thread_.get_id() == std::this_thread::get_id())
+                return false;
+            dispatch_thread_stop_ = true;
+            std::swap(thread, dispatch_thread_);
+        }
+        dispatch_thread_cv_.notify_one();
+        thread.join();
+        has_dispatch_thread_.store(false);
+        return true;
+    }
+
+    void EventQueue::notify_dispatch_thread() {
+        {
+            std::lock_guard<std::mutex> guard(dispatch_thread_mutex_);
+            dispatch_thread_notified_ = true;
+        }
+        dispatch_thread_cv_.notify_one();
+    }
+
+    void EventQueue::dispatch_thread_fct() {
+        while (true) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(dispatch_thread_mutex_);
+                dispatch_thread_cv_.wait(lock, [this]() {
+                    return dispatch_thread_notified_ || dispatch_thread_stop_;
+                    });
+                dispatch_thread_notified_ = false;
+                stop = dispatch_thread_stop_;
+            }
+            pollEvents();
+            if (stop)
+                break;
+            // Events carried over because of the dispatch budget
+            if (getQueueDepth() > 0) {
+                std::lock_guard<std::mutex> guard(dispatch_thread_mutex_);
+                dispatch_thread_notified_ = true;
             }
         }
+    }
+
+    void EventQueue::subscribe(Listener* listener) {
+        listeners_.add(listener);
+    }
 
-        if (has_found) {
+    Subscription EventQueue::subscribe(std::string filter, std::function<void(Event_ptr&)> callback) {
+        auto listener = std::make_shared<Listener>();
+        listener->filter = std::move(filter);
+        listener->callback = std::move(callback);
+        Listener* listener_ptr = listener.get();
+        listeners_.add(listener_ptr, std::move(listener));
+        return Subscription([this, listener_ptr]() { unsubscribe(listener_ptr); });
+    }
+
+    void EventQueue::unsubscribe(Listener* listener) {
+        if (!listeners_.contains(listener))
+            return;
+
+        bool unsubscribe_later = false;
+        {
             std::lock_guard<std::mutex> guard(pending_mutex_);
-            bool unsubscribe_later = false;
             for (auto& name : pending_acknowledged_events_) {
                 if (isListener(listener->filter, name)) {
                     unsubscribe_later = true;
@@ -53,62 +130,293 @@ namespace Tempo {
             if (unsubscribe_later) {
                 to_remove_.insert(listener);
             }
-            else {
-                listeners_.erase(listener);
-            }
+        }
+        if (!unsubscribe_later) {
+            listeners_.remove(listener);
         }
     }
 
     void EventQueue::post(Event_ptr event) {
+        if (event->isAcknowledgable()) {
+            std::lock_guard<std::mutex> guard(pending_mutex_);
+            pending_acknowledged_events_.push_back(event->getName());
+        }
         {
-            std::lock_guard<std::recursive_mutex> guard(event_mutex_);
-            event_queue_.push(event);
+            std::lock_guard<std::mutex> guard(event_mutex_);
+            event_lanes_[event->getPriority()].push_back(event);
+        }
+        requestWakeup(event->getName());
+    }
+
+    void EventQueue::setWakeupCallback(std::function<void()> callback) {
+        if (callback)
+            wakeup_callback_.store(std::make_shared<const std::function<void()>>(std::move(callback)));
+        else
+            wakeup_callback_.store(nullptr);
+        wake_pending_.store(false);
+    }
+
+    void EventQueue::setWakeup(const std::string& filter, bool wake) {
+        std::lock_guard<std::mutex> guard(wakeup_rules_mutex_);
+        auto current = wakeup_rules_.load();
+        auto rules = current ? std::make_shared<std::vector<WakeupRule>>(*current) : std::make_shared<std::vector<WakeupRule>>();
+        rules->push_back(WakeupRule{ filter, wake });
+        wakeup_rules_.store(std::move(rules));
+    }
+
+    void EventQueue::requestWakeup(const std::string& event_name) {
+        // Cheap check first: a wakeup is already pending for this batch
+        if (wake_pending_.load())
+            return;
+        auto callback = wakeup_callback_.load();
+        const bool has_dispatch_thread = has_dispatch_thread_.load();
+        if (!callback && !has_dispatch_thread)
+            return;
+
+        auto rules = wakeup_rules_.load();
+        if (rules) {
+            for (auto it = rules->rbegin(); it != rules->rend(); it++) {
+                if (isListener(it->filter, event_name)) {
+                    if (!it->wake)
+                        return;
+                    break;
+                }
+            }
         }
-        if (event.get()->isAcknowledgable()) {
+        if (!wake_pending_.exchange(true)) {
+            if (has_dispatch_thread)
+                notify_dispatch_thread();
+            if (callback)
+                (*callback)();
+        }
+    }
+
+    Event_ptr EventQueue::pop_event(int lane) {
+        std::lock_guard<std::mutex> guard(event_mutex_);
+        if (event_lanes_[lane].empty())
+            return nullptr;
+        Event_ptr event = std::move(event_lanes_[lane].front());
+        event_lanes_[lane].pop_front();
+        return event;
+    }
+
+    void EventQueue::dispatch_event(Event_ptr& event, DispatchLatency& latency) {
+        latency.add(event->getTime());
+        auto snapshot = listeners_.snapshot();
+        auto observer = observer_.load();
+        if (observer) {
+            using clock = std::chrono::steady_clock;
+            const auto start = clock::now();
+            observer->onDispatchBegin(*event);
+            for (const auto& entry : *snapshot) {
+                ListenerList<Listener>::CallGuard call(*entry);
+                if (!call.isActive())
+                    continue;
+                if (isListener(entry->listener->filter, event->getName())) {
+                    const auto listener_start = clock::now();
+                    entry->listener->callback(event);
+                    observer->onListenerCalled(*event, entry->listener->filter, clock::now() - listener_start);
+                }
+            }
+            observer->onDispatchEnd(*event, clock::now() - start);
+        }
+        else {
+            for (const auto& entry : *snapshot) {
+                ListenerList<Listener>::CallGuard call(*entry);
+                if (!call.isActive())
+                    continue;
+                if (isListener(entry->listener->filter, event->getName())) {
+                    entry->listener->callback(event);
+                }
+            }
+        }
+
+        if (event->isAcknowledgable()) {
             std::lock_guard<std::mutex> guard(pending_mutex_);
-            pending_acknowledged_events_.push_back(event.get()->getName());
+            auto it = std::find(pending_acknowledged_events_.begin(), pending_acknowledged_events_.end(), event->getName());
+            if (it != pending_acknowledged_events_.end())
+                pending_acknowledged_events_.erase(it);
         }
-        // glfwPostEmptyEvent();
     }
 
     void EventQueue::pollEvents() {
-        {
-            std::lock_guard<std::recursive_mutex> event_guard(event_mutex_);
-            while (!event_queue_.empty()) {
-                std::shared_ptr<Event> event = event_queue_.front();
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        const long long budget_us = dispatch_budget_us_.load();
+        const auto deadline = budget_us > 0 ? start + std::chrono::microseconds(budget_us) : clock::time_point::max();
 
-                std::lock_guard<std::recursive_mutex> listener_guard(listeners_mutex_);
-                for (const auto& listener : listeners_) {
-                    bool filter_ok = isListener(listener->filter, event->getName());
+        // Events posted from now on need a new wakeup
+        wake_pending_.store(false);
 
-                    if (filter_ok) {
-                        listener->callback(event);
+        size_t dispatched = 0;
+        DispatchLatency latency;
+        {
+            ListenerList<Listener>::DispatchGuard dispatch_guard(listeners_);
+            // At least one event per lane is dispatched, so that no lane starves
+            size_t dispatched_per_lane[Event::EVENT_PRIORITY_COUNT] = {};
+            for (int lane = 0; lane < Event::EVENT_PRIORITY_COUNT; lane++) {
+                bool has_budget = true;
+                // Events posted while dispatching (e.g. from a callback) are dispatched in the same poll,
+                // and high priority events always preempt the current lane
+                while (true) {
+                    int current_lane = Event::EVENT_PRIORITY_HIGH;
+                    Event_ptr event = pop_event(Event::EVENT_PRIORITY_HIGH);
+                    if (!event && lane != Event::EVENT_PRIORITY_HIGH) {
+                        if (clock::now() < deadline) {
+                            for (int higher = Event::EVENT_PRIORITY_HIGH + 1; higher <= lane && !event; higher++) {
+                                event = pop_event(higher);
+                                current_lane = higher;
+                            }
+                        }
+                        else {
+                            // Budget is spent: the lane only gets its guaranteed event, taken from
+                            // its own queue (the events of the lanes above wait for the next poll)
+                            has_budget = false;
+                            if (dispatched_per_lane[lane] == 0) {
+                                event = pop_event(lane);
+                                current_lane = lane;
+                            }
+                        }
+                    }
+                    if (!event)
+                        break;
+                    dispatch_event(event, latency);
+                    dispatched++;
+                    dispatched_per_lane[current_lane]++;
+                }
+                {
+                    // Channels of the same priority
+                    std::lock_guard<std::recursive_mutex> guard(channels_mutex_);
+                    // Iterating by index, because a callback could create a new channel
+                    for (size_t i = 0; i < channels_.size(); i++) {
+                        if (channels_[i]->getPriority() != lane)
+                            continue;
+                        if (lane == Event::EVENT_PRIORITY_HIGH)
+                            channels_[i]->pollEvents(clock::time_point::max(), &latency);
+                        else
+                            channels_[i]->pollEvents(has_budget ? deadline : clock::now(), &latency);
                     }
                 }
-                event_queue_.pop();
             }
         }
         {
-            std::lock_guard<std::recursive_mutex> guard(listeners_mutex_);
             // Check if there are listeners that need to be unsubscribed after a poll
-            for (auto listener : to_remove_) {
-                listeners_.erase((listener));
+            std::vector<Listener*> to_remove;
+            {
+                std::lock_guard<std::mutex> guard(pending_mutex_);
+                for (auto it = to_remove_.begin(); it != to_remove_.end();) {
+                    bool still_pending = false;
+                    for (auto& name : pending_acknowledged_events_) {
+                        if (isListener((*it)->filter, name)) {
+                            still_pending = true;
+                            break;
+                        }
+                    }
+                    if (still_pending) {
+                        it++;
+                    }
+                    else {
+                        to_remove.push_back(*it);
+                        it = to_remove_.erase(it);
+                    }
+                }
+            }
+            for (auto listener : to_remove) {
+                listeners_.remove(listener);
             }
         }
+
+        const auto dispatch_time = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+        size_t carried_over = 0;
         {
-            std::lock_guard<std::mutex> guard(pending_mutex_);
-            pending_acknowledged_events_.clear();
-            to_remove_.clear();
+            std::lock_guard<std::mutex> guard(event_mutex_);
+            for (int lane = 0; lane < Event::EVENT_PRIORITY_COUNT; lane++)
+                carried_over += event_lanes_[lane].size();
+        }
+        std::lock_guard<std::mutex> guard(stats_mutex_);
+        stats_.dispatched_last_poll = dispatched;
+        stats_.carried_over = carried_over;
+        stats_.last_dispatch_time = dispatch_time;
+        if (dispatch_time > stats_.max_dispatch_time)
+            stats_.max_dispatch_time = dispatch_time;
+        if (latency.count > 0) {
+            total_latency_us_ += latency.total_us;
+            stats_.latency_samples += latency.count;
+            stats_.mean_latency = std::chrono::microseconds(total_latency_us_ / (long long)stats_.latency_samples);
+            if (std::chrono::microseconds(latency.max_us) > stats_.max_latency)
+                stats_.max_latency = std::chrono::microseconds(latency.max_us);
         }
     }
 
+    void EventQueue::setDispatchBudget(std::chrono::microseconds budget) {
+        dispatch_budget_us_.store(budget.count());
+    }
+
+    size_t EventQueue::getQueueDepth() const {
+        size_t depth = 0;
+        {
+            std::lock_guard<std::mutex> guard(event_mutex_);
+            for (int lane = 0; lane < Event::EVENT_PRIORITY_COUNT; lane++)
+                depth += event_lanes_[lane].size();
+        }
+        std::lock_guard<std::recursive_mutex> guard(channels_mutex_);
+        for (auto channel : channels_)
+            depth += channel->getQueueDepth();
+        return depth;
+    }
+
+    EventQueueStats EventQueue::getStats() const {
+        EventQueueStats stats;
+        {
+            std::lock_guard<std::mutex> guard(stats_mutex_);
+            stats = stats_;
+        }
+        {
+            std::lock_guard<std::mutex> guard(event_mutex_);
+            for (int lane = 0; lane < Event::EVENT_PRIORITY_COUNT; lane++)
+                stats.queue_depth[lane] = event_lanes_[lane].size();
+        }
+        std::lock_guard<std::recursive_mutex> guard(channels_mutex_);
+        for (auto channel : channels_)
+            stats.queue_depth[channel->getPriority()] += channel->getQueueDepth();
+        return stats;
+    }
+
+    void EventQueue::setObserver(std::shared_ptr<EventQueueObserver> observer) {
+        observer_.store(std::move(observer));
+    }
+
+    std::shared_ptr<EventQueueObserver> EventQueue::getObserver() const {
+        return observer_.load();
+    }
+
+    void EventQueue::resetStats() {
+        std::lock_guard<std::mutex> guard(stats_mutex_);
+        stats_.max_dispatch_time = std::chrono::microseconds(0);
+        stats_.mean_latency = std::chrono::microseconds(0);
+        stats_.max_latency = std::chrono::microseconds(0);
+        stats_.latency_samples = 0;
+        total_latency_us_ = 0;
+    }
+
+    void EventQueue::addChannel(EventChannelBase* channel) {
+        std::lock_guard<std::recursive_mutex> guard(channels_mutex_);
+        if (std::find(channels_.begin(), channels_.end(), channel) == channels_.end())
+            channels_.push_back(channel);
+    }
+
+    void EventQueue::removeChannel(EventChannelBase* channel) {
+        std::lock_guard<std::recursive_mutex> guard(channels_mutex_);
+        channels_.erase(std::remove(channels_.begin(), channels_.end(), channel), channels_.end());
+    }
+
     size_t EventQueue::getNumSubscribers(const std::vector<std::string>& event_names) {
         std::set<Listener*> listener_set;
-        std::lock_guard<std::recursive_mutex> listener_guard(listeners_mutex_);
+        auto snapshot = listeners_.snapshot();
         for (const auto& event_name : event_names) {
-            for (const auto listener : listeners_) {
-                if (isListener(listener->filter, event_name)) {
-                    listener_set.insert(listener);
+            for (const auto& entry : *snapshot) {
+                if (isListener(entry->listener->filter, event_name)) {
+                    listener_set.insert(entry->listener);
                 }
             }
         }
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <new>
+#include <deque>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -16,10 +22,24 @@ namespace Tempo {
      * create custom events
      */
     class Event {
+    public:
+        /**
+         * Priority lanes of the events
+         * Higher priority events are always dispatched before lower priority events
+         * and are not subject to the dispatch budget of the EventQueue
+         */
+        enum eventPriority {
+            EVENT_PRIORITY_HIGH,   // Input and UI control (e.g. shortcuts)
+            EVENT_PRIORITY_NORMAL, // Default
+            EVENT_PRIORITY_LOW,    // Telemetry and logs
+            EVENT_PRIORITY_COUNT
+        };
+
     protected:
         std::string name_;
         std::chrono::system_clock::time_point time_;
         bool acknowledgable_ = false;
+        eventPriority priority_ = EVENT_PRIORITY_NORMAL;
 
     public:
         /**
@@ -31,8 +51,10 @@ namespace Tempo {
          * Setting this variable to true will indicate the EventQueue that every listener
          * listening this event is not allowed to unsubscribe before every event in the queue
          * has been polled, otherwise there could be concurrency problems.
+         * @param priority lane in which the event is dispatched
          */
-        explicit Event(std::string name, bool acknowledgable = false) : name_(std::move(name)), time_(std::chrono::system_clock::now()), acknowledgable_(acknowledgable) {}
+        explicit Event(std::string name, bool acknowledgable = false, eventPriority priority = EVENT_PRIORITY_NORMAL)
+            : name_(std::move(name)), time_(std::chrono::system_clock::now()), acknowledgable_(acknowledgable), priority_(priority) {}
 
         /**
          * @return returns the name of the event
@@ -44,20 +66,470 @@ namespace Tempo {
          */
         bool isAcknowledgable() const { return acknowledgable_; }
 
+        /**
+         * @return returns the priority lane of the event
+         */
+        eventPriority getPriority() const { return priority_; }
+
         /**
          * @return returns the time at which the event was posted
          */
         const std::chrono::system_clock::time_point& getTime() const { return time_; }
 
+        /**
+         * @return approximate size in bytes of the event (used for tracing)
+         * Custom events holding data should override this function
+         */
+        virtual size_t getSize() const { return sizeof(Event) + name_.size(); }
+
         virtual ~Event() = default;
     };
     typedef std::shared_ptr<Event> Event_ptr;
 
+    /**
+     * @brief Free list of the memory blocks of the events of a given size
+     *
+     * Freed blocks are kept (up to max_free_blocks) and reused by the next events of
+     * the same size, so that posting an event in a steady state does not go through the heap.
+     * Thread-safe: an event is usually freed by another thread than the one which posted it
+     */
+    template <size_t Size, size_t Align>
+    class EventPool {
+    private:
+        struct Block {
+            Block* next;
+        };
+        static constexpr size_t block_size = Size > sizeof(Block) ? Size : sizeof(Block);
+        static constexpr size_t block_align = Align > alignof(Block) ? Align : alignof(Block);
+        static constexpr size_t max_free_blocks = 1024;
+
+        std::mutex mutex_;
+        Block* free_ = nullptr;
+        size_t num_free_ = 0;
+
+        EventPool() = default;
+
+    public:
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        EventPool(EventPool const&) = delete;
+        void operator=(EventPool const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the pool
+         */
+        static EventPool& getInstance() {
+            // Never destroyed: events can still be freed by other static objects at exit
+            static EventPool* instance = new EventPool();
+            return *instance;
+        }
+
+        void* allocate() {
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                if (free_ != nullptr) {
+                    Block* block = free_;
+                    free_ = block->next;
+                    num_free_--;
+                    return block;
+                }
+            }
+            return ::operator new(block_size, std::align_val_t(block_align));
+        }
+
+        void deallocate(void* ptr) {
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                if (num_free_ < max_free_blocks) {
+                    Block* block = static_cast<Block*>(ptr);
+                    block->next = free_;
+                    free_ = block;
+                    num_free_++;
+                    return;
+                }
+            }
+            ::operator delete(ptr, std::align_val_t(block_align));
+        }
+    };
+
+    /**
+     * Allocator of the events (and of their shared_ptr control block) in the EventPool
+     */
+    template <typename U>
+    struct EventPoolAllocator {
+        using value_type = U;
+
+        EventPoolAllocator() = default;
+        template <typename V>
+        EventPoolAllocator(const EventPoolAllocator<V>&) {}
+
+        U* allocate(size_t n) {
+            if (n != 1)
+                return static_cast<U*>(::operator new(n * sizeof(U), std::align_val_t(alignof(U))));
+            return static_cast<U*>(EventPool<sizeof(U), alignof(U)>::getInstance().allocate());
+        }
+
+        void deallocate(U* ptr, size_t n) {
+            if (n != 1)
+                ::operator delete(ptr, std::align_val_t(alignof(U)));
+            else
+                EventPool<sizeof(U), alignof(U)>::getInstance().deallocate(ptr);
+        }
+
+        template <typename V>
+        bool operator==(const EventPoolAllocator<V>&) const { return true; }
+        template <typename V>
+        bool operator!=(const EventPoolAllocator<V>&) const { return false; }
+    };
+
+    /**
+     * @brief Creates an event of type T and its shared_ptr control block in a single
+     * block of the EventPool, instead of two heap allocations with `Event_ptr(new T(...))`
+     *
+     * @code{.cpp}
+     * EventQueue::getInstance().post(MakeEvent<Event>("events/1"));
+     * @endcode
+     * @param args arguments forwarded to the constructor of T
+     */
+    template <typename T = Event, typename... Args>
+    std::shared_ptr<T> MakeEvent(Args&&... args) {
+        return std::allocate_shared<T>(EventPoolAllocator<T>(), std::forward<Args>(args)...);
+    }
+
     struct Listener {
         std::string filter;
         std::function<void(Event_ptr&)> callback;
     };
 
+    /**
+     * shared_ptr that can be loaded and stored atomically
+     * (std::atomic<std::shared_ptr> is only available from C++20)
+     */
+    template <typename T>
+    class AtomicSharedPtr {
+    private:
+#ifdef __cpp_lib_atomic_shared_ptr
+        std::atomic<std::shared_ptr<T>> ptr_;
+    public:
+        std::shared_ptr<T> load() const { return ptr_.load(); }
+        void store(std::shared_ptr<T> ptr) { ptr_.store(std::move(ptr)); }
+#else
+        std::shared_ptr<T> ptr_;
+    public:
+        std::shared_ptr<T> load() const { return std::atomic_load(&ptr_); }
+        void store(std::shared_ptr<T> ptr) { std::atomic_store(&ptr_, std::move(ptr)); }
+#endif
+    };
+
+    /**
+     * @brief Copy-on-write list of listeners
+     *
+     * Each subscription or unsubscription publishes a new immutable snapshot
+     * of the list, so that dispatching can iterate over the listeners without
+     * holding any lock.
+     *
+     * An unsubscribed listener is deactivated before the new snapshot is published,
+     * which means that dispatching over an older snapshot never calls it.
+     * Each call of a listener is counted in its entry (see CallGuard): remove() waits
+     * until the calls of this listener in progress on other threads are finished,
+     * such that the listener can safely be freed when remove() returns. The calls of
+     * the other listeners, and the rest of the dispatch, are not waited for.
+     */
+    template <typename L>
+    class ListenerList {
+    public:
+        struct Entry {
+            L* listener;
+            // Set when the listener is owned by a Subscription
+            std::shared_ptr<L> owned;
+            std::atomic<bool> active{ true };
+            // Calls of the listener in progress
+            std::atomic<int> calls{ 0 };
+        };
+        using Snapshot = std::vector<std::shared_ptr<Entry>>;
+
+        /**
+         * Guard to hold while calling listeners of a snapshot
+         * Dispatches of the same list are serialized (a nested dispatch from a
+         * callback is allowed), removals do not wait for it
+         */
+        class DispatchGuard {
+        private:
+            ListenerList& list_;
+        public:
+            explicit DispatchGuard(ListenerList& list) : list_(list) {
+                list_.dispatch_mutex_.lock();
+            }
+            ~DispatchGuard() {
+                list_.dispatch_mutex_.unlock();
+            }
+            DispatchGuard(DispatchGuard const&) = delete;
+            void operator=(DispatchGuard const&) = delete;
+        };
+
+        /**
+         * Guard to hold while calling the listener of an entry
+         * The listener must not be accessed if the guard is not active (it may be freed)
+         */
+        class CallGuard {
+        private:
+            Entry& entry_;
+            bool active_;
+        public:
+            explicit CallGuard(Entry& entry) : entry_(entry) {
+                // Counted before checking the flag: either remove() sees the call, or the call sees the removal
+                entry_.calls.fetch_add(1);
+                active_ = entry_.active.load();
+                if (active_)
+                    calling().push_back(&entry_);
+            }
+            ~CallGuard() {
+                if (active_)
+                    calling().pop_back();
+                entry_.calls.fetch_sub(1);
+            }
+            bool isActive() const { return active_; }
+            CallGuard(CallGuard const&) = delete;
+            void operator=(CallGuard const&) = delete;
+        };
+
+    private:
+        AtomicSharedPtr<const Snapshot> snapshot_;
+        std::mutex write_mutex_;
+        std::recursive_mutex dispatch_mutex_;
+
+        /**
+         * @return entries whose listener is being called by the current thread
+         */
+        static std::vector<const Entry*>& calling() {
+            thread_local std::vector<const Entry*> entries;
+            return entries;
+        }
+
+    public:
+        ListenerList() {
+            snapshot_.store(std::make_shared<const Snapshot>());
+        }
+
+        /**
+         * @return current snapshot of the listeners, which never changes once published
+         */
+        std::shared_ptr<const Snapshot> snapshot() const { return snapshot_.load(); }
+
+        /**
+         * @return true if the listener is in the current snapshot
+         */
+        bool contains(const L* listener) const {
+            auto current = snapshot_.load();
+            for (const auto& entry : *current) {
+                if (entry->listener == listener)
+                    return true;
+            }
+            return false;
+        }
+
+        /**
+         * Publishes a new snapshot containing the listener
+         * @param listener pointer to the listener
+         * @param owned if not null, the listener will be freed once it is removed and
+         * no snapshot references it anymore
+         * @return false if the listener was already in the list
+         */
+        bool add(L* listener, std::shared_ptr<L> owned = nullptr) {
+            std::lock_guard<std::mutex> guard(write_mutex_);
+            auto current = snapshot_.load();
+            for (const auto& entry : *current) {
+                if (entry->listener == listener)
+                    return false;
+            }
+            auto entry = std::make_shared<Entry>();
+            entry->listener = listener;
+            entry->owned = std::move(owned);
+
+            auto next = std::make_shared<Snapshot>(*current);
+            next->push_back(std::move(entry));
+            snapshot_.store(std::move(next));
+            return true;
+        }
+
+        /**
+         * Publishes a new snapshot without the listener
+         * @param listener pointer to the listener
+         * @return false if the listener was not in the list
+         */
+        bool remove(const L* listener) {
+            std::shared_ptr<Entry> removed;
+            {
+                std::lock_guard<std::mutex> guard(write_mutex_);
+                auto current = snapshot_.load();
+                auto next = std::make_shared<Snapshot>();
+                next->reserve(current->size());
+                for (const auto& entry : *current) {
+                    if (entry->listener == listener) {
+                        entry->active.store(false);
+                        removed = entry;
+                    }
+                    else {
+                        next->push_back(entry);
+                    }
+                }
+                if (!removed)
+                    return false;
+                snapshot_.store(std::move(next));
+            }
+            // Grace period: wait for the calls of this listener on the other threads
+            // (the listener can be removed from its own callback, or from a nested call)
+            const auto& current_calls = calling();
+            const int own_calls = (int)std::count(current_calls.begin(), current_calls.end(), removed.get());
+            while (removed->calls.load() > own_calls) {
+                std::this_thread::yield();
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief RAII handle of a subscription
+     *
+     * The listener is unsubscribed when the handle is destroyed or reset.
+     * The handle must not outlive the EventQueue or EventChannel that created it.
+     */
+    class Subscription {
+    private:
+        std::function<void()> unsubscribe_;
+
+    public:
+        Subscription() = default;
+        explicit Subscription(std::function<void()> unsubscribe) : unsubscribe_(std::move(unsubscribe)) {}
+
+        Subscription(Subscription const&) = delete;
+        void operator=(Subscription const&) = delete;
+
+        Subscription(Subscription&& other) noexcept : unsubscribe_(std::move(other.unsubscribe_)) {
+            other.unsubscribe_ = nullptr;
+        }
+        Subscription& operator=(Subscription&& other) noexcept {
+            if (this != &other) {
+                reset();
+                unsubscribe_ = std::move(other.unsubscribe_);
+                other.unsubscribe_ = nullptr;
+            }
+            return *this;
+        }
+
+        ~Subscription() { reset(); }
+
+        /**
+         * Unsubscribes the listener now
+         */
+        void reset() {
+            if (unsubscribe_) {
+                auto unsubscribe = std::move(unsubscribe_);
+                unsubscribe_ = nullptr;
+                unsubscribe();
+            }
+        }
+
+        /**
+         * @return true if the handle still holds a subscription
+         */
+        bool isActive() const { return (bool)unsubscribe_; }
+    };
+
+    /**
+     * @brief Observer of the dispatch of an EventQueue (and of its channels)
+     *
+     * The functions are called from the thread that polls the queue, for every
+     * dispatched event, so they must be cheap (see EventTraceRecorder)
+     */
+    class EventQueueObserver {
+    public:
+        virtual ~EventQueueObserver() = default;
+
+        /**
+         * Called before the listeners of the event are called
+         */
+        virtual void onDispatchBegin(const Event& event) = 0;
+
+        /**
+         * Called after each listener that received the event
+         * @param filter filter of the listener
+         * @param duration time spent in the callback of the listener
+         */
+        virtual void onListenerCalled(const Event& event, const std::string& filter, std::chrono::nanoseconds duration) = 0;
+
+        /**
+         * Called once all the listeners of the event have been called
+         * @param duration total time of the dispatch of the event
+         */
+        virtual void onDispatchEnd(const Event& event, std::chrono::nanoseconds duration) = 0;
+    };
+
+    /**
+     * Accumulates the latencies between the moment events are posted and dispatched
+     */
+    struct DispatchLatency {
+        long long total_us = 0;
+        long long max_us = 0;
+        size_t count = 0;
+
+        void add(const std::chrono::system_clock::time_point& posted_at) {
+            long long latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - posted_at).count();
+            total_us += latency;
+            if (latency > max_us)
+                max_us = latency;
+            count++;
+        }
+    };
+
+    /**
+     * Base class of the typed event channels (see EventChannel<T> in event_channel.h)
+     * Channels register themselves to an EventQueue, which then polls them
+     * each time EventQueue::pollEvents() is called
+     */
+    class EventChannelBase {
+    public:
+        virtual ~EventChannelBase() = default;
+
+        /**
+         * Dispatches the events that have been posted to the channel
+         * @param deadline once the deadline is passed, the remaining events are
+         * kept for the next call (at least one event is dispatched per call)
+         * @param latency if not null, accumulates the post to dispatch latency of the events
+         * @return true if all the events have been dispatched
+         */
+        virtual bool pollEvents(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(), DispatchLatency* latency = nullptr) = 0;
+
+        /**
+         * @return number of events waiting to be dispatched
+         */
+        virtual size_t getQueueDepth() const = 0;
+
+        /**
+         * @return priority lane of the channel
+         */
+        virtual Event::eventPriority getPriority() const = 0;
+    };
+
+    /**
+     * Statistics of the dispatch of an EventQueue
+     */
+    struct EventQueueStats {
+        // Number of events waiting to be dispatched in each lane (channels included)
+        size_t queue_depth[Event::EVENT_PRIORITY_COUNT] = {};
+        // Number of named events dispatched during the last poll
+        size_t dispatched_last_poll = 0;
+        // Number of named events that were left for the next poll because of the budget
+        size_t carried_over = 0;
+        std::chrono::microseconds last_dispatch_time{ 0 };
+        std::chrono::microseconds max_dispatch_time{ 0 };
+        // Latency between the post of an event and its dispatch (since the last reset)
+        std::chrono::microseconds mean_latency{ 0 };
+        std::chrono::microseconds max_latency{ 0 };
+        size_t latency_samples = 0;
+    };
+
     /**
      * @brief The EventQueue is a thread-safe singleton that manages all events
      * (posting and polling events, alerting the listeners)\n
@@ -106,8 +578,15 @@ namespace Tempo {
      * // num_listen should not have changed because the listener unsubscribed
      *
      * queue.pollEvents();
+     *
+     * // Alternatively, the queue can own the listener, which is unsubscribed
+     * // when the returned handle is destroyed
+     * Subscription subscription = queue.subscribe("events*", [] (Event_ptr& event) {});
      * @endcode
      *
+     * Subscribing and unsubscribing never blocks the dispatch: pollEvents() reads
+     * an immutable snapshot of the listeners (see ListenerList).
+     *
      * @note It is recommended to call the queue.pollEvents() from the main thread.
      * However, if one desires to call pollEvents() from another thread, then it is
      * up to the user to guarantee the thread safety of the lambdas created in the
@@ -115,32 +594,110 @@ namespace Tempo {
      */
     class EventQueue {
     private:
-        std::queue<Event_ptr> event_queue_;
-        std::recursive_mutex event_mutex_;
-        std::set<Listener*> listeners_;
-        std::recursive_mutex listeners_mutex_;
+        std::deque<Event_ptr> event_lanes_[Event::EVENT_PRIORITY_COUNT];
+        mutable std::mutex event_mutex_;
+        ListenerList<Listener> listeners_;
+
+        std::atomic<long long> dispatch_budget_us_{ 0 };
+        EventQueueStats stats_;
+        long long total_latency_us_ = 0;
+        mutable std::mutex stats_mutex_;
+
+        struct WakeupRule {
+            std::string filter;
+            bool wake;
+        };
+        AtomicSharedPtr<const std::function<void()>> wakeup_callback_;
+        AtomicSharedPtr<const std::vector<WakeupRule>> wakeup_rules_;
+        std::mutex wakeup_rules_mutex_;
+        // Set when the wakeup callback has been called since the last poll
+        std::atomic<bool> wake_pending_{ false };
+
+        AtomicSharedPtr<EventQueueObserver> observer_;
 
         std::set<Listener*> to_remove_;
         std::vector<std::string> pending_acknowledged_events_;
         std::mutex pending_mutex_;
 
-        EventQueue() = default;
+        std::vector<EventChannelBase*> channels_;
+        mutable std::recursive_mutex channels_mutex_;
+
+        std::string name_;
+
+        std::thread dispatch_thread_;
+        std::mutex dispatch_thread_mutex_;
+        std::condition_variable dispatch_thread_cv_;
+        bool dispatch_thread_notified_ = false;
+        bool dispatch_thread_stop_ = false;
+        std::atomic<bool> has_dispatch_thread_{ false };
+
+        void dispatch_thread_fct();
+        /**
+         * Stops and joins the dispatch thread
+         * @return false if called from the dispatch thread (nothing is done)
+         */
+        bool stop_dispatch_thread() noexcept;
+        void notify_dispatch_thread();
+
+        /**
+         * Pops the next event of the given lane
+         * @return nullptr if the lane is empty
+         */
+        Event_ptr pop_event(int lane);
+
+        void dispatch_event(Event_ptr& event, DispatchLatency& latency);
 
     public:
         /**
-         * Copy constructors stay empty, because of the Singleton
+         * @brief Creates an independent event bus
+         *
+         * Each bus has its own events, listeners, channels and locks, so that heavy
+         * traffic (e.g. telemetry) does not compete with the UI bus (getInstance()).
+         * A bus is either polled manually with pollEvents(), or drained by its own
+         * thread (see startDispatchThread). Topics can be forwarded from one bus to
+         * another with an EventBridge.
+         *
+         * @code{.cpp}
+         * EventQueue telemetry_bus("telemetry");
+         * telemetry_bus.startDispatchThread();
+         * // Telemetry listeners are called on the dispatch thread of the bus
+         * auto subscription = telemetry_bus.subscribe("telemetry/stats", [](Event_ptr& event) { ... });
+         * // Only the alerts are forwarded to the UI
+         * EventBridge alerts(telemetry_bus, EventQueue::getInstance(), "telemetry/alert*");
+         * @endcode
+         *
+         * The bus must outlive its listeners, channels and bridges.
+         * @param name name of the bus, for debugging purposes
+         */
+        explicit EventQueue(std::string name = "");
+
+        /**
+         * Stops the dispatch thread, if any
+         * @note must not be called from a listener of the bus (asserts, the thread is detached)
+         */
+        ~EventQueue();
+
+        /**
+         * Copy constructors stay empty, because listeners and channels keep a reference to the bus
          */
         EventQueue(EventQueue const&) = delete;
         void operator=(EventQueue const&) = delete;
 
         /**
-         * @return instance of the Singleton of the EventQueue
+         * @return the UI bus, which is polled by the main loop in Tempo::Run
          */
         static EventQueue& getInstance() {
-            static EventQueue instance;
+            static EventQueue instance("main");
             return instance;
         }
 
+        /**
+         * @return name of the bus
+         */
+        const std::string& getName() const {
+            return name_;
+        }
+
         /**
          * @brief Adds a listener which will observe the event queue
          * It is not possible to add the same listener multiple time
@@ -152,10 +709,22 @@ namespace Tempo {
          */
         void subscribe(Listener* listener);
 
+        /**
+         * @brief Adds a listener owned by the queue
+         *
+         * @param filter filter of the events (see isListener)
+         * @param callback function called for each corresponding event
+         * @return handle which unsubscribes the listener when destroyed
+         */
+        Subscription subscribe(std::string filter, std::function<void(Event_ptr&)> callback);
+
         /**
          * @biref Removes the listener from the event queue
          * Use this function before freeing the pointer of the listener
          *
+         * If there are acknowledgable events in the queue that correspond to
+         * the listener, the listener is only removed once these events have been polled
+         *
          * @note Unsubscribing a listener that has never been added does nothing
          * @param listener pointer to Listener stucture
          */
@@ -181,20 +750,143 @@ namespace Tempo {
          *
          * @param event shared ptr of Event or daughter of Event
          * Posting a shared ptr of Event avoids problems with segfault because
-         * there could be multiple listeners that consume the Event
+         * there could be multiple listeners that consume the Event.
+         * Events created with MakeEvent reuse the memory of the previous events
+         *
+         * If a wakeup callback is set (see setWakeupCallback), posting an event
+         * wakes up the thread that polls the queue
          */
         void post(Event_ptr event);
 
+        /**
+         * @brief Sets the function that wakes up the thread polling the queue
+         * (e.g. glfwPostEmptyEvent for the main loop)
+         *
+         * Wakeups are coalesced: the callback is called at most once between two
+         * calls of pollEvents(), however many events are posted.
+         * The callback must be thread-safe.
+         *
+         * @param callback wakeup function, nullptr to disable the wakeups
+         */
+        void setWakeupCallback(std::function<void()> callback);
+
+        /**
+         * @brief Opts in or out of the wakeups for the given events
+         * By default, all events wake up the polling thread. When multiple
+         * rules correspond to an event, the last one added wins
+         *
+         * @param filter filter of the events (see isListener)
+         * @param wake if false, posting the events does not wake up the polling thread;
+         * they are dispatched the next time the queue is polled for another reason
+         */
+        void setWakeup(const std::string& filter, bool wake);
+
+        /**
+         * @brief Wakes up the polling thread if the event corresponds to a waking topic
+         * and no wakeup is already pending
+         *
+         * Is called by post() and by the typed channels
+         * @param event_name name of the posted event
+         */
+        void requestWakeup(const std::string& event_name);
+
         /**
          * @brief Polls the posted events
          * This function looks for all current listeners that correspond to the events
          * in the queue and calls the corresponding callbacks
          *
+         * Lanes are dispatched by priority (named events first, then the channels of the
+         * same priority). High priority events are always dispatched, whereas normal and
+         * low priority events are only dispatched until the budget is spent (see
+         * setDispatchBudget); the remaining events are carried over to the next poll.
+         * Once the budget is spent, each lane still dispatches one of its own events, so that
+         * a backlog of normal priority events does not starve the low priority lane.
+         *
          * @note It is recommended to call the function from the main thread.
          * However, if one desires to call pollEvents() from another thread, then it is
          * up to the user to guarantee the thread safety of the lambdas created in the
          * listeners.
          */
         void pollEvents();
+
+        /**
+         * @brief Starts a thread which drains the bus
+         *
+         * The thread sleeps until an event is posted (same rules as the wakeup callback,
+         * see setWakeup), then polls the bus; listeners and channels of the bus are
+         * then called on this thread. pollEvents() should not be called manually
+         * while the thread runs.
+         *
+         * Does nothing if the thread is already running.
+         */
+        void startDispatchThread();
+
+        /**
+         * @brief Stops the dispatch thread
+         * The events posted before the call are dispatched before the thread exits
+         *
+         * Does nothing if there is no dispatch thread.
+         * @note must not be called from a listener of the bus
+         */
+        void stopDispatchThread();
+
+        /**
+         * @return true if the bus is drained by its own thread
+         */
+        bool hasDispatchThread() const {
+            return has_dispatch_thread_.load();
+        }
+
+        /**
+         * @brief Registers a typed channel, which will be polled along with the
+         * named events each time pollEvents() is called
+         *
+         * This function is called by the constructor of EventChannel<T>, there
+         * should be no need to call it manually
+         * @param channel pointer to the channel
+         */
+        void addChannel(EventChannelBase* channel);
+
+        /**
+         * @brief Removes a typed channel from the queue
+         *
+         * @param channel pointer to the channel
+         */
+        void removeChannel(EventChannelBase* channel);
+
+        /**
+         * @brief Sets the time budget of pollEvents() for the normal and low priority lanes
+         *
+         * @param budget maximum dispatch time per poll, 0 means no limit
+         */
+        void setDispatchBudget(std::chrono::microseconds budget);
+
+        /**
+         * @return number of events (named and from channels) waiting to be dispatched
+         */
+        size_t getQueueDepth() const;
+
+        /**
+         * @return statistics of the dispatch (queue depth, dispatch times)
+         */
+        EventQueueStats getStats() const;
+
+        /**
+         * Resets the maximum dispatch time and the latencies of the statistics
+         */
+        void resetStats();
+
+        /**
+         * @brief Sets the observer of the dispatch (e.g. EventTraceRecorder)
+         * Listeners are only timed when an observer is set
+         *
+         * @param observer observer, nullptr to remove it
+         */
+        void setObserver(std::shared_ptr<EventQueueObserver> observer);
+
+        /**
+         * @return current observer of the dispatch, nullptr if there is none
+         */
+        std::shared_ptr<EventQueueObserver> getObserver() const;
     };
 }
\ No newline at end of file
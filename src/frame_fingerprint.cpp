@@ -0,0 +1,106 @@
+#include "frame_fingerprint.h"
+#include "damage.h"
+
+#include <cstring>
+
+namespace Tempo {
+    namespace {
+        constexpr uint64_t hash_multiplier = 0x9E3779B97F4A7C15ULL;
+
+        inline uint64_t mix(uint64_t hash, uint64_t value) {
+            hash ^= value;
+            hash *= hash_multiplier;
+            return hash ^ (hash >> 29);
+        }
+
+        /*
+         * Hashes 8 bytes at a time, the vertex buffers are hashed every frame
+         * (hashBytes, which hashes byte per byte, is too slow for them)
+         */
+        uint64_t hash_buffer(const void* data, size_t size, uint64_t hash) {
+            const unsigned char* bytes = (const unsigned char*)data;
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, sizeof(word));
+                hash = mix(hash, word);
+            }
+            if (i < size) {
+                uint64_t word = 0;
+                std::memcpy(&word, bytes + i, size - i);
+                hash = mix(hash, word);
+            }
+            return mix(hash, (uint64_t)size);
+        }
+
+        template<typename T>
+        uint64_t hash_value(const T& value, uint64_t hash) {
+            return hash_buffer(&value, sizeof(T), hash);
+        }
+    }
+
+    uint64_t FrameFingerprint::compute(const ImDrawData* draw_data, uint64_t seed) {
+        uint64_t hash = seed;
+        hash = hash_value(draw_data->DisplayPos, hash);
+        hash = hash_value(draw_data->DisplaySize, hash);
+        hash = hash_value(draw_data->FramebufferScale, hash);
+        hash = mix(hash, (uint64_t)draw_data->CmdListsCount);
+        for (int n = 0; n < draw_data->CmdListsCount; n++) {
+            hash = hashDrawList(draw_data->CmdLists[n], hash);
+            if (hash == 0)
+                return 0;
+        }
+        return hash;
+    }
+
+    uint64_t FrameFingerprint::hashDrawList(const ImDrawList* cmd_list, uint64_t seed) {
+        uint64_t hash = seed;
+        for (const ImDrawCmd& cmd : cmd_list->CmdBuffer) {
+            // Callbacks can draw anything (except the reset of the render state)
+            if (cmd.UserCallback != nullptr && cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                return 0;
+            hash = hash_value(cmd.ClipRect, hash);
+            hash = mix(hash, (uint64_t)(uintptr_t)cmd.TextureId);
+            hash = mix(hash, ((uint64_t)cmd.VtxOffset << 32) | cmd.IdxOffset);
+            hash = mix(hash, (uint64_t)cmd.ElemCount);
+        }
+        hash = hash_buffer(cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.size_in_bytes(), hash);
+        hash = hash_buffer(cmd_list->IdxBuffer.Data, (size_t)cmd_list->IdxBuffer.size_in_bytes(), hash);
+        return hash;
+    }
+
+    uint64_t FrameFingerprint::computeFrame(uint64_t seed) {
+        uint64_t hash = mix(0xcbf29ce484222325ULL, seed);
+        ImGuiPlatformIO& platform_io = ImGui::GetPlatformIO();
+        for (ImGuiViewport* viewport : platform_io.Viewports) {
+            if (viewport->DrawData == nullptr)
+                continue;
+            hash = mix(hash, (uint64_t)viewport->ID);
+            hash = compute(viewport->DrawData, hash);
+            if (hash == 0)
+                return 0;
+        }
+        return hash;
+    }
+
+    bool FrameFingerprint::update(uint64_t fingerprint) {
+        stats_.frames++;
+        // 0 is used for the frames which cannot be fingerprinted
+        if (valid_ && fingerprint != 0 && fingerprint == last_) {
+            stats_.skipped++;
+            return false;
+        }
+        last_ = fingerprint;
+        valid_ = fingerprint != 0;
+        return true;
+    }
+
+    void InvalidateFrame() {
+        FrameFingerprint::getInstance().invalidate();
+        DamageTracker::getInstance().invalidate();
+    }
+
+    FrameSkipStats GetFrameSkipStats() {
+        return FrameFingerprint::getInstance().getStats();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <imgui.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Tempo {
+    /**
+     * Frames rendered and skipped since the start (see Config::skip_identical_frames)
+     */
+    struct FrameSkipStats {
+        size_t frames = 0;
+        size_t skipped = 0;
+    };
+
+    /**
+     * @brief Detects the frames whose ImGui output is identical to the previous one
+     *
+     * The fingerprint of a frame is a hash of the draw data of all the viewports
+     * (commands, clip rects, texture ids, vertex and index buffers) and of
+     * the size of their framebuffers. When it did not change, drawing and swapping
+     * the buffers would present the same image again, so the frame is skipped.
+     *
+     * Frames with user callbacks (ImDrawCmd::UserCallback) are always rendered,
+     * as their output cannot be known. Textures updated in place (same id) are not
+     * seen, invalidate() must be called after such an update
+     *
+     * Must be used from the main thread
+     */
+    class FrameFingerprint {
+    private:
+        uint64_t last_ = 0;
+        bool valid_ = false;
+        FrameSkipStats stats_;
+
+        FrameFingerprint() = default;
+
+    public:
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        FrameFingerprint(FrameFingerprint const&) = delete;
+        void operator=(FrameFingerprint const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the FrameFingerprint
+         */
+        static FrameFingerprint& getInstance() {
+            static FrameFingerprint instance;
+            return instance;
+        }
+
+        /**
+         * @brief Hashes the draw data of a viewport
+         * @param seed previous hash, to hash multiple viewports one after the other
+         * @return 0 if the draw data contains user callbacks
+         */
+        static uint64_t compute(const ImDrawData* draw_data, uint64_t seed);
+
+        /**
+         * @brief Hashes the commands, vertices and indices of a draw list
+         * @return 0 if the draw list contains user callbacks
+         */
+        static uint64_t hashDrawList(const ImDrawList* cmd_list, uint64_t seed);
+
+        /**
+         * @brief Fingerprint of the frame which has just been rendered by ImGui::Render
+         * (all the viewports with draw data)
+         * @param seed state outside of the draw data that changes the image (e.g. the font textures)
+         */
+        static uint64_t computeFrame(uint64_t seed);
+
+        /**
+         * @brief Compares the fingerprint with the one of the last rendered frame
+         * @return true if the frame must be rendered, false if it can be skipped
+         */
+        bool update(uint64_t fingerprint);
+
+        /**
+         * Forces the next frame to be rendered (resize, damaged window, textures updated in place)
+         */
+        void invalidate() {
+            valid_ = false;
+        }
+
+        FrameSkipStats getStats() const {
+            return stats_;
+        }
+    };
+
+    /**
+     * @brief Forces the next frame to be drawn, even if its draw data is the same
+     * as the previous one (see Config::skip_identical_frames), and fully drawn
+     * with damage tracking (see Config::damage_tracking)
+     *
+     * Must be called when the content of a texture drawn by ImGui has been
+     * updated in place
+     */
+    void InvalidateFrame();
+
+    FrameSkipStats GetFrameSkipStats();
+}
\ No newline at end of file
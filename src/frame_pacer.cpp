@@ -0,0 +1,158 @@
+#include "frame_pacer.h"
+
+#ifndef __gl_h_
+#include <glad/glad.h>
+#endif
+#include <GLFW/glfw3.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace Tempo {
+    namespace {
+        double to_ms(FramePacer::clock::duration duration) {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+    }
+
+    FramePacer::clock::duration FramePacer::period() const {
+        if (target_fps_ <= 0.)
+            return clock::duration::zero();
+        // glfwSwapBuffers already limits the rate to the refresh rate
+        if (vsync_ && refresh_rate_ > 0 && target_fps_ >= (double)refresh_rate_ - 0.5)
+            return clock::duration::zero();
+        return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1. / target_fps_));
+    }
+
+    FramePacer::clock::duration FramePacer::refresh_period() const {
+        const int refresh_rate = refresh_rate_ > 0 ? refresh_rate_ : 60;
+        return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1. / refresh_rate));
+    }
+
+    void FramePacer::sleep_until(clock::time_point deadline) {
+        // Events received while sleeping are processed, but do not start the frame earlier
+        while (true) {
+            auto remaining = deadline - clock::now();
+            if (remaining <= spin_time)
+                break;
+            glfwWaitEventsTimeout(std::chrono::duration<double>(remaining - spin_time).count());
+        }
+        while (clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    void FramePacer::setTargetFps(double fps) {
+        target_fps_ = std::max(fps, 0.);
+    }
+
+    void FramePacer::keepActiveUntil(clock::time_point until) {
+        active_until_ = std::max(active_until_, until);
+    }
+
+    void FramePacer::notifyInput() {
+        keepActiveUntil(clock::now() + active_time_);
+    }
+
+    void FramePacer::updateActivity() {
+        // An active item is not an input: a focused text field waits for the keys,
+        // its cursor blink is scheduled as a deadline. Drags hold a mouse button
+        ImGuiIO& io = ImGui::GetIO();
+        const bool input = io.MouseDelta.x != 0.f || io.MouseDelta.y != 0.f
+            || io.MouseWheel != 0.f || io.MouseWheelH != 0.f
+            || !io.InputQueueCharacters.empty()
+            || ImGui::IsAnyMouseDown();
+        if (input)
+            notifyInput();
+    }
+
+    void FramePacer::frameSkipped() {
+        // Without a limit, the rate is set by glfwSwapBuffers, which is not called
+        // for a skipped frame: the wait for the monitor is replaced by a sleep
+        if (period() > clock::duration::zero() || !has_frame_)
+            return;
+        sleep_until(frame_start_ + refresh_period());
+    }
+
+    bool FramePacer::isActive(clock::time_point now) const {
+        return always_active_ || now < active_until_;
+    }
+
+    void FramePacer::waitForNextFrame(double idle_timeout, std::optional<clock::time_point> deadline) {
+        const bool active = isActive();
+        const clock::duration frame_period = period();
+        if (active) {
+            if (frame_period > clock::duration::zero() && has_frame_)
+                sleep_until(frame_start_ + frame_period);
+            glfwPollEvents();
+        }
+        else {
+            double timeout = idle_timeout;
+            if (deadline.has_value()) {
+                const double until_deadline = std::chrono::duration<double>(*deadline - clock::now()).count();
+                if (timeout <= 0. || until_deadline < timeout)
+                    timeout = std::max(until_deadline, 0.);
+            }
+            if (deadline.has_value() && timeout <= 0.)
+                glfwPollEvents();
+            else if (timeout > 0.)
+                glfwWaitEventsTimeout(timeout);
+            else
+                glfwWaitEvents();
+        }
+
+        const auto now = clock::now();
+        stats_.frames++;
+        if (active) {
+            stats_.active_frames++;
+            // Intervals are only regular between two active frames
+            if (has_frame_ && frame_active_) {
+                const auto interval = now - frame_start_;
+                intervals_[next_interval_] = to_ms(interval);
+                next_interval_ = (next_interval_ + 1) % max_samples;
+                num_intervals_ = std::min(num_intervals_ + 1, max_samples);
+
+                clock::duration expected = frame_period;
+                if (expected == clock::duration::zero() && vsync_ && refresh_rate_ > 0)
+                    expected = refresh_period();
+                if (expected > clock::duration::zero() && interval > expected + expected / 2)
+                    stats_.missed_deadlines++;
+            }
+        }
+        frame_start_ = now;
+        has_frame_ = true;
+        frame_active_ = active;
+    }
+
+    FramePacerStats FramePacer::getStats() const {
+        FramePacerStats stats = stats_;
+        if (num_intervals_ == 0)
+            return stats;
+
+        std::vector<double> intervals(intervals_.begin(), intervals_.begin() + (std::ptrdiff_t)num_intervals_);
+        double sum = 0.;
+        for (double interval : intervals) {
+            sum += interval;
+        }
+        stats.mean_interval_ms = sum / (double)intervals.size();
+        double variance = 0.;
+        for (double interval : intervals) {
+            variance += (interval - stats.mean_interval_ms) * (interval - stats.mean_interval_ms);
+        }
+        stats.jitter_ms = std::sqrt(variance / (double)intervals.size());
+
+        std::sort(intervals.begin(), intervals.end());
+        stats.p99_interval_ms = intervals[(size_t)(0.99 * (double)(intervals.size() - 1))];
+        stats.max_interval_ms = intervals.back();
+        return stats;
+    }
+
+    void FramePacer::reset() {
+        stats_ = FramePacerStats{};
+        num_intervals_ = 0;
+        next_interval_ = 0;
+    }
+}
\ No newline at end of file
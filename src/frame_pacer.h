@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace Tempo {
+    /**
+     * Frame times measured by the FramePacer
+     * Only the frames rendered at the target rate (active) are used for the intervals,
+     * idle frames are started by events and have no regular interval
+     */
+    struct FramePacerStats {
+        size_t frames = 0;
+        size_t active_frames = 0;
+        // Frames which started more than half a period after their deadline
+        size_t missed_deadlines = 0;
+        // Interval between the starts of consecutive active frames, over the last 256 frames
+        double mean_interval_ms = 0.;
+        // Standard deviation of the interval
+        double jitter_ms = 0.;
+        double p99_interval_ms = 0.;
+        double max_interval_ms = 0.;
+    };
+
+    /**
+     * @brief Decides when the main loop starts the next frame
+     *
+     * The loop is either active, and renders at the target frame rate, or idle, and
+     * waits for events (input, posted events, timeouts). It is active:
+     * - during the active time following an input (ImGui mouse or keyboard input, a held mouse button)
+     * - until the time given to keepActiveUntil (PollUntil, animations)
+     * - always, if the application uses Config::POLL
+     *
+     * When idle, the wait ends at the earliest deadline (see DeadlineRegistry),
+     * so timers and scheduled tasks are never missed and nothing has to poll.
+     *
+     * While active, the pacer sleeps until the start of the next frame, while still
+     * receiving the events. The end of the sleep is spun for precision, because
+     * the timeouts of the OS are coarse. With vsync, glfwSwapBuffers already waits for
+     * the monitor, so the pacer only sleeps if the target is below the refresh rate.
+     *
+     * Must be used from the main thread
+     */
+    class FramePacer {
+    public:
+        using clock = std::chrono::steady_clock;
+
+    private:
+        static constexpr size_t max_samples = 256;
+        // The sleep ends this long before the deadline, the rest is spun
+        static constexpr std::chrono::microseconds spin_time{ 2000 };
+
+        double target_fps_ = 0.;
+        bool vsync_ = true;
+        int refresh_rate_ = 0;
+        bool always_active_ = false;
+        clock::duration active_time_ = std::chrono::milliseconds(500);
+        clock::time_point active_until_;
+
+        clock::time_point frame_start_;
+        bool has_frame_ = false;
+        bool frame_active_ = false;
+        FramePacerStats stats_;
+        std::array<double, max_samples> intervals_{};
+        size_t num_intervals_ = 0;
+        size_t next_interval_ = 0;
+
+        FramePacer() = default;
+
+        /**
+         * @return time between two active frames, 0 if the rate is not limited by the pacer
+         */
+        clock::duration period() const;
+
+        /**
+         * @return time between two refreshes of the monitor (60 Hz if unknown)
+         */
+        clock::duration refresh_period() const;
+
+        void sleep_until(clock::time_point deadline);
+
+    public:
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        FramePacer(FramePacer const&) = delete;
+        void operator=(FramePacer const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the FramePacer
+         */
+        static FramePacer& getInstance() {
+            static FramePacer instance;
+            return instance;
+        }
+
+        /**
+         * @brief Sets the frame rate of the active loop
+         * @param fps frames per second, 0 means no limit (the refresh rate with vsync)
+         */
+        void setTargetFps(double fps);
+        double getTargetFps() const { return target_fps_; }
+
+        /**
+         * @brief Tells the pacer whether glfwSwapBuffers waits for the monitor
+         */
+        void setVSync(bool vsync) { vsync_ = vsync; }
+
+        /**
+         * @brief Refresh rate (Hz) of the monitor of the main window, 0 if unknown
+         */
+        void setRefreshRate(int refresh_rate) { refresh_rate_ = refresh_rate; }
+
+        /**
+         * @brief If true, the loop never waits for events (Config::POLL)
+         */
+        void setAlwaysActive(bool always_active) { always_active_ = always_active; }
+
+        /**
+         * @brief Time during which the loop stays active after an input
+         */
+        void setActiveTime(clock::duration duration) { active_time_ = duration; }
+
+        /**
+         * @brief Keeps the loop active until the given time (e.g. end of an animation)
+         */
+        void keepActiveUntil(clock::time_point until);
+
+        /**
+         * @brief Marks an input, the loop stays active for the active time
+         */
+        void notifyInput();
+
+        /**
+         * @brief Marks an input if ImGui received or is processing one this frame
+         * (mouse moved, held or scrolled, typed characters)
+         * Must be called between ImGui::NewFrame and ImGui::Render
+         */
+        void updateActivity();
+
+        /**
+         * @brief Tells the pacer that the frame has not been presented (identical to the last one)
+         *
+         * If the rate is not limited by the pacer, sleeps until one refresh period after the
+         * start of the frame, as glfwSwapBuffers would have with vsync. Otherwise the loop
+         * would spin on identical frames
+         */
+        void frameSkipped();
+
+        /**
+         * @return true if the next frame is rendered at the target rate
+         */
+        bool isActive(clock::time_point now = clock::now()) const;
+
+        /**
+         * @brief Processes the events and returns once the next frame must start
+         *
+         * Active: sleeps until the deadline of the next frame (if the rate is limited),
+         * then polls the events. Idle: waits for an event, the deadline or the timeout,
+         * whichever comes first.
+         *
+         * @param idle_timeout maximum wait when idle (seconds), 0 means no timeout
+         * @param deadline earliest time at which a frame must be rendered, if any
+         */
+        void waitForNextFrame(double idle_timeout, std::optional<clock::time_point> deadline = std::nullopt);
+
+        FramePacerStats getStats() const;
+
+        /**
+         * Forgets all the measured frames
+         */
+        void reset();
+    };
+}
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "../utils.h"
 #include "../keyboard_shortcuts.h"
 #include "../config.h"
+#include "../frame_fingerprint.h"
 
 namespace Tempo {
     std::multimap<int, GLFWwindow*> GLFWwindowHandler::windows;
@@ -13,8 +14,14 @@ namespace Tempo {
     bool GLFWwindowHandler::all_windows_unfocused = false;
     App* GLFWwindowHandler::application = nullptr;
     std::string GLFWwindowHandler::config_name = "default";
+    GLFWwindowfocusfun GLFWwindowHandler::prev_focus_callback_ = nullptr;
+
+    void GLFWwindowHandler::focus_callback(GLFWwindow* window, int focused) {
+        if (prev_focus_callback_)
+            prev_focus_callback_(window, focused);
+        if (focused == GLFW_TRUE)
+            KeyboardShortCut::rebuildKeyTranslation();
 
-    void GLFWwindowHandler::focus_callback(GLFWwindow*, int) {
         // If previously all windows were unfocused and
         // the user clicked on a window, we can put all windows from
         // the app to the front (if focus_all == true)
@@ -49,12 +56,17 @@ namespace Tempo {
 
     void GLFWwindowHandler::addWindow(GLFWwindow* window, int z_index, bool main_window) {
         windows.insert(std::pair<int, GLFWwindow*>(z_index, window));
-        // glfwSetWindowFocusCallback(window, &GLFWwindowHandler::focus_callback);
+        auto focus_fun = glfwSetWindowFocusCallback(window, &GLFWwindowHandler::focus_callback);
+        // addWindow can be called again for the same window (see setZIndex)
+        if (focus_fun != &GLFWwindowHandler::focus_callback)
+            prev_focus_callback_ = focus_fun;
         auto fun = glfwSetKeyCallback(window, &KeyboardShortCut::key_callback);
-        KeyboardShortCut::set_prev_key_callback(fun);
+        if (fun != &KeyboardShortCut::key_callback)
+            KeyboardShortCut::set_prev_key_callback(fun);
         //glfwSetCharCallback(window, &KeyboardShortCut::character_callback);
         if (main_window) {
             glfwSetFramebufferSizeCallback(window, &GLFWwindowHandler::framebuffer_size_callback);
+            glfwSetWindowRefreshCallback(window, &GLFWwindowHandler::window_refresh_callback);
             glfwSetWindowMaximizeCallback(window, &GLFWwindowHandler::window_maximize_callback);
             glfwSetWindowPosCallback(window, &GLFWwindowHandler::window_pos_callback);
         }
@@ -76,9 +88,14 @@ namespace Tempo {
 
     void GLFWwindowHandler::framebuffer_size_callback(GLFWwindow* window, int width, int height) {
         // TODO Multi-threaded app: https://stackoverflow.com/a/56614042/8523520
+        FrameFingerprint::getInstance().invalidate();
         renderApplication(window, width, height, application);
         saveWindowSize(config_name, width, height);
     }
+    void GLFWwindowHandler::window_refresh_callback(GLFWwindow*) {
+        // The content of the window has been damaged (e.g. uncovered), it must be drawn again
+        FrameFingerprint::getInstance().invalidate();
+    }
     void GLFWwindowHandler::window_maximize_callback(GLFWwindow*, int maximized) {
         saveWindowMaximized(config_name, maximized == GLFW_TRUE);
     }
@@ -18,6 +18,8 @@ namespace Tempo {
         static std::multimap<int, GLFWwindow*> windows;
         static bool all_windows_unfocused;
         static std::string config_name;
+        // Focus callback installed before ours (e.g. by ImGui)
+        static GLFWwindowfocusfun prev_focus_callback_;
     public:
         /**
          * If focus_all is set to true, then
@@ -33,6 +35,11 @@ namespace Tempo {
          */
         static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
+        /**
+         * Callback for GLFW when the content of the window must be drawn again
+         */
+        static void window_refresh_callback(GLFWwindow* window);
+
         /**
          * Callback for GLFW when maximizing or unmaximizing the window
         */
@@ -48,6 +55,8 @@ namespace Tempo {
 
         /**
          * Callback for GLFW when any window is focused or defocused
+         * The keyboard layout may have changed while the application was not focused,
+         * so the translation table of the keys is rebuilt when a window gains the focus
          * @param window glfw window pointer
          * @param focused state of the focus (GLFW_TRUE or GLFW_FALSE)
          */
@@ -4,6 +4,7 @@
 #include "utils.h"
 #include "glfw_handler/glfw_window_handler.h"
 #include "events.h"
+#include "event_trace.h"
 #include "jobscheduler.h"
 #include "config.h"
 #include "text/fonts_private.h"
\ No newline at end of file
@@ -220,8 +220,13 @@ namespace Tempo {
         std::string event_name = std::string("jobs/ids/") + std::to_string(job->id);
         std::string event_name2 = std::string("jobs/names/") + job->name;
 
-        event_queue_.post(Event_ptr(new JobEvent(event_name, job)));
-        event_queue_.post(Event_ptr(new JobEvent(event_name2, job)));
+        // Deprecated path, for the listeners of the EventQueue (removed in the next release)
+        EventQueue& event_queue = EventQueue::getInstance();
+        event_queue.post(MakeEvent<JobEvent>(event_name, job));
+        event_queue.post(MakeEvent<JobEvent>(event_name2, job));
+
+        job_events_.post(std::move(event_name), job);
+        job_events_.post(std::move(event_name2), std::move(job));
     }
 
     void JobScheduler::remove_job_from_list(JobReference& jobReference) {
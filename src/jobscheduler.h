@@ -11,7 +11,7 @@
 #include <condition_variable>
 #include <utility>
 
-#include "events.h"
+#include "event_channel.h"
 
 
 namespace Tempo {
@@ -93,14 +93,27 @@ namespace Tempo {
         std::shared_ptr<JobResult> result;
     };
 
+    /**
+     * Event posted by the JobScheduler in EventChannel<JobEvent> whenever a job stops
+     * (also posted in EventQueue::getInstance() until the next release, see JOBEVENT_PTRCAST)
+     */
     class JobEvent: public Event {
     private:
         std::shared_ptr<Job> job_;
     public:
-        JobEvent(std::string& name, std::shared_ptr<Job> job): Event(name), job_(std::move(job)) {}
-        std::shared_ptr<Job> getJob() { return job_; }
+        JobEvent(std::string name, std::shared_ptr<Job> job): Event(std::move(name)), job_(std::move(job)) {}
+        const std::shared_ptr<Job>& getJob() const { return job_; }
+
+        size_t getSize() const override { return sizeof(JobEvent) + name_.size(); }
     };
-#define JOBEVENT_PTRCAST(job) (reinterpret_cast<JobEvent*>((job)))
+
+    /**
+     * @deprecated Job events are posted in EventChannel<JobEvent>, whose listeners receive
+     * a const JobEvent&. They are still posted in the EventQueue until the next release
+     */
+    [[deprecated("Subscribe to EventChannel<JobEvent> instead")]]
+    inline JobEvent* job_event_cast(Event* event) { return static_cast<JobEvent*>(event); }
+#define JOBEVENT_PTRCAST(job) (::Tempo::job_event_cast((job)))
 
     /**
      * Custom Job reference to give ability to compare priorities between
@@ -203,10 +216,10 @@ namespace Tempo {
         Semaphore semaphore_;
         std::list<Worker> workers_;
 
-        EventQueue& event_queue_;
+        EventChannel<JobEvent>& job_events_;
 
         /**
-         * Post an JobEvent to the event queue
+         * Post an JobEvent to the job event channel
          * If nobody was listening to the event corresponding of this job, the function returns false
          */
         void post_event(std::shared_ptr<Job> job);
@@ -220,7 +233,7 @@ namespace Tempo {
 
         static jobResultFct no_op_fct;
 
-        JobScheduler(): event_queue_(EventQueue::getInstance()) {
+        JobScheduler(): job_events_(EventChannel<JobEvent>::getInstance()) {
             setWorkerPoolSize(4);
         }
 
@@ -254,7 +267,8 @@ namespace Tempo {
          *
          * Once a job is launched, whenever a job stops (FINISHED, ABORTED, CANCELED, ERROR),
          * the JobScheduler will send two events : `jobs/names/[name]` and `jobs/ids/[job_id]`
-         * The user can subscribe to either of these events
+         * The user can subscribe to either of these events with a TypedListener<JobEvent>
+         * on EventChannel<JobEvent>::getInstance() (subscribing on the EventQueue is deprecated)
          *
          * @param name name of the job
          * @param function lambda function to be executed by the job. The function should be in this format :
@@ -1,5 +1,7 @@
 #include "keyboard_shortcuts.h"
+#include "frame_pacer.h"
 
+#include <algorithm>
 #include <iostream>
 #include "imgui.h"
 //#include <clocale>
@@ -7,13 +9,27 @@
 namespace Tempo {
     void no_op_callback(GLFWwindow*, int, int, int, int) {}
 
-    std::deque<KeyEvent> KeyboardShortCut::keyboard_events_;
-    std::vector<Shortcut> KeyboardShortCut::global_shortcuts_;
-    std::vector<Shortcut> KeyboardShortCut::local_shortcuts_;
+    SPSCRingBuffer<KeyEvent, 256> KeyboardShortCut::key_events_;
+    std::array<KeyboardShortCut::HistoryEntry, KeyboardShortCut::max_history_length> KeyboardShortCut::history_;
+    size_t KeyboardShortCut::num_presses_ = 0;
+    size_t KeyboardShortCut::oldest_press_ = 0;
+    size_t KeyboardShortCut::num_live_presses_ = 0;
+    size_t KeyboardShortCut::history_length_ = 6;
+    std::array<size_t, GLFW_KEY_LAST + 1> KeyboardShortCut::last_press_{};
+    std::vector<KeyboardShortCut::CompiledShortcut> KeyboardShortCut::global_shortcuts_;
+    std::vector<KeyboardShortCut::CompiledShortcut> KeyboardShortCut::local_shortcuts_;
+    std::vector<std::vector<size_t>> KeyboardShortCut::global_shortcuts_index_(GLFW_KEY_LAST + 1);
     EventQueue& KeyboardShortCut::eventQueue_ = EventQueue::getInstance();
+    std::bitset<GLFW_KEY_LAST + 1> KeyboardShortCut::held_keys_;
+    std::vector<int> KeyboardShortCut::new_presses_;
+    std::vector<size_t> KeyboardShortCut::candidates_;
+    std::vector<size_t> KeyboardShortCut::completed_global_;
+    std::vector<KeyboardShortCut::CompiledShortcut> KeyboardShortCut::completed_local_;
     bool KeyboardShortCut::ignore_global_shortcuts_ = false;
-    std::mutex KeyboardShortCut::mutex;
     GLFWkeyfun KeyboardShortCut::prev_key_callback_ = no_op_callback;
+    std::array<int, GLFW_KEY_LAST + 1> KeyboardShortCut::key_translation_;
+    std::array<std::string, GLFW_KEY_LAST + 1> KeyboardShortCut::key_names_;
+    bool KeyboardShortCut::is_key_translation_built_ = false;
 
     /*
      * Character utilities
@@ -72,138 +88,243 @@ namespace Tempo {
         return 0;
     }
 
+    // The matching only works on the first 32 keys of a shortcut
+    static constexpr size_t max_shortcut_keys = 32;
+
+    static inline bool isModifierKey(int key) {
+        return key == GLFW_KEY_LEFT_CONTROL || key == GLFW_KEY_RIGHT_CONTROL
+            || key == GLFW_KEY_LEFT_SUPER || key == GLFW_KEY_RIGHT_SUPER
+            || key == GLFW_KEY_LEFT_ALT || key == GLFW_KEY_RIGHT_ALT
+            || key == GLFW_KEY_LEFT_SHIFT || key == GLFW_KEY_RIGHT_SHIFT;
+    }
+
+    static inline bool isValidKey(int key) {
+        return key >= 0 && key <= GLFW_KEY_LAST;
+    }
+
     /*
      * Implementation of KeyboardShortCut
      */
-    bool KeyboardShortCut::is_shortcut_valid(Shortcut& shortcut) {
-        bool is_valid = false;
-
-        timepoint previous_time;
-        bool no_time_check = true;
-        if (!keyboard_events_.empty()) {
-            previous_time = keyboard_events_[0].time;
-            no_time_check = false;
+    KeyboardShortCut::CompiledShortcut KeyboardShortCut::compile(const Shortcut& shortcut, const std::string& prefix) {
+        CompiledShortcut compiled;
+        compiled.shortcut = shortcut;
+        compiled.event_name = prefix + shortcut.name;
+        compiled.keys.reserve(shortcut.keys.size());
+        for (auto key : shortcut.keys) {
+            if (compiled.keys.size() == max_shortcut_keys)
+                break;
+            switch (key) {
+            case KEY_CTRL:
+                compiled.keys.push_back({ GLFW_KEY_LEFT_CONTROL, GLFW_KEY_RIGHT_CONTROL });
+                break;
+            case KEY_ALT:
+                compiled.keys.push_back({ GLFW_KEY_LEFT_ALT, GLFW_KEY_RIGHT_ALT });
+                break;
+            case KEY_SHIFT:
+                compiled.keys.push_back({ GLFW_KEY_LEFT_SHIFT, GLFW_KEY_RIGHT_SHIFT });
+                break;
+            case KEY_ENTER:
+                compiled.keys.push_back({ GLFW_KEY_ENTER, GLFW_KEY_KP_ENTER });
+                break;
+            case KEY_SUPER:
+                compiled.keys.push_back({ GLFW_KEY_LEFT_SUPER, GLFW_KEY_RIGHT_SUPER });
+                break;
+            default:
+                compiled.keys.push_back({ key, -1 });
+            }
         }
-        float time_between_keys = 0;
-
-        // Once a shortcut is complete, it "consumes" the key events in the deque
-        std::vector<std::deque<KeyEvent>::iterator> to_erase;
-
-        for (auto it = keyboard_events_.begin(); it != keyboard_events_.end(); it++) {
-            auto& event = *it;
-            auto shortcut_iterator = find_key(shortcut, event.key);
-            time_between_keys = (float)std::chrono::duration_cast<std::chrono::milliseconds>(previous_time - event.time).count();
-            if (no_time_check)
-                time_between_keys = 0;
-
-            if (shortcut_iterator != shortcut.tmp_keys.end()
-                && (event.state == GLFW_PRESS || time_between_keys < shortcut.delay)) {
-
-                shortcut.tmp_keys.erase(shortcut_iterator);
-                if (event.key != GLFW_KEY_LEFT_CONTROL && event.key != GLFW_KEY_RIGHT_CONTROL
-                    && event.key != GLFW_KEY_LEFT_SUPER && event.key != GLFW_KEY_RIGHT_SUPER
-                    && event.key != GLFW_KEY_LEFT_ALT && event.key != GLFW_KEY_RIGHT_ALT
-                    && event.key != GLFW_KEY_LEFT_SHIFT && event.key != GLFW_KEY_RIGHT_SHIFT)
-                    to_erase.push_back(it);
-
-                // The shortcut is complete
-                if (shortcut.tmp_keys.empty()) {
-                    is_valid = true;
+        return compiled;
+    }
+
+    bool KeyboardShortCut::is_held(const CompiledShortcut& compiled) {
+        for (const auto& alternatives : compiled.keys) {
+            bool held = false;
+            for (auto key : alternatives) {
+                if (isValidKey(key) && held_keys_.test((size_t)key)) {
+                    held = true;
                     break;
                 }
+            }
+            if (!held)
+                return false;
+        }
+        return true;
+    }
 
-                // Only update the previous time of the key if the key was found in the shortcut
-                previous_time = event.time;
+    bool KeyboardShortCut::uses_new_presses(const CompiledShortcut& compiled) {
+        for (auto pressed : new_presses_) {
+            for (const auto& alternatives : compiled.keys) {
+                if (alternatives[0] == pressed || alternatives[1] == pressed)
+                    return true;
             }
         }
+        return false;
+    }
+
+    bool KeyboardShortCut::is_shortcut_valid(const CompiledShortcut& compiled) {
+        const auto& keys = compiled.keys;
+        if (keys.empty() || num_presses_ == 0)
+            return false;
+        // Without delay, all the keys must be held down
+        if (compiled.shortcut.delay == 0 && !is_held(compiled))
+            return false;
 
-        // Empty the queue until the last key event taken by the shortcut
-        if (is_valid) {
-            for (auto& it : to_erase)
-                keyboard_events_.erase(it);
+        // Keys of the shortcut already found, and presses taken by the shortcut
+        const uint32_t all_keys = keys.size() == max_shortcut_keys ? ~0u : (1u << keys.size()) - 1;
+        uint32_t found_keys = 0;
+        std::array<HistoryEntry*, max_shortcut_keys> taken;
+        size_t num_taken = 0;
+
+        timepoint previous_time;
+        bool has_previous_time = false;
+        // From the most recent press to the oldest one
+        for (size_t n = num_presses_; n-- > oldest_press_;) {
+            auto& entry = history_[n % max_history_length];
+            if (entry.consumed)
+                continue;
+            const auto& event = entry.event;
+            if (!has_previous_time) {
+                previous_time = event.time;
+                has_previous_time = true;
+            }
+            float time_between_keys = (float)std::chrono::duration_cast<std::chrono::milliseconds>(previous_time - event.time).count();
+            if (event.state != GLFW_PRESS && !(time_between_keys < compiled.shortcut.delay))
+                continue;
+
+            size_t key_index = 0;
+            for (; key_index < keys.size(); key_index++) {
+                if (!(found_keys & (1u << key_index)) && (keys[key_index][0] == event.key || keys[key_index][1] == event.key))
+                    break;
+            }
+            if (key_index == keys.size())
+                continue;
+
+            found_keys |= 1u << key_index;
+            // Once a shortcut is complete, it "consumes" the key presses
+            if (!isModifierKey(event.key))
+                taken[num_taken++] = &entry;
+
+            if (found_keys == all_keys) {
+                for (size_t i = 0; i < num_taken; i++)
+                    taken[i]->consumed = true;
+                num_live_presses_ -= num_taken;
+                return true;
+            }
+
+            // Only update the previous time of the key if the key was found in the shortcut
+            previous_time = event.time;
         }
+        return false;
+    }
 
-        return is_valid;
+    void KeyboardShortCut::fire(CompiledShortcut& compiled) {
+        eventQueue_.post(MakeEvent<Event>(compiled.event_name, false, Event::EVENT_PRIORITY_HIGH));
+        if (compiled.shortcut.callback != NULL) {
+            // The callback may add shortcuts, which can move the compiled shortcut
+            auto callback = compiled.shortcut.callback;
+            callback();
+        }
     }
 
     void KeyboardShortCut::key_callback(GLFWwindow* window, int key, int shortcode, int action, int mods) {
         {
             prev_key_callback_(window, key, shortcode, action, mods);
         }
-        {
-            std::lock_guard<std::mutex> guard(mutex);
-            key = translate_keycode(key);
-            if (action == GLFW_PRESS) {
-                //last_keystroke_ = key;
-                KeyEvent keyevent = { key, GLFW_PRESS, std::chrono::system_clock::now() };
-                keyboard_events_.push_front(keyevent);
-
-                if (keyboard_events_.size() > KEYBOARD_SHORTCUT_QUEUE_LENGTH)
-                    keyboard_events_.pop_back();
-            }
-            else if (action == GLFW_RELEASE) {
-                for (auto& event : keyboard_events_) {
-                    if (key == event.key) {
-                        event.state = GLFW_RELEASE;
-                        break;
-                    }
+        InputLatencyTracker::getInstance().recordInput();
+        FramePacer::getInstance().notifyInput();
+        key_events_.push(KeyEvent{ translate_keycode(key), action, std::chrono::system_clock::now() });
+    }
+
+    void KeyboardShortCut::process_key_events() {
+        KeyEvent event;
+        while (key_events_.pop(event)) {
+            const bool is_valid_key = isValidKey(event.key);
+            if (event.state == GLFW_PRESS) {
+                push_press(event);
+                if (is_valid_key) {
+                    held_keys_.set((size_t)event.key);
+                    last_press_[(size_t)event.key] = num_presses_;
                 }
+                // Older presses have left the history anyway
+                if (new_presses_.size() >= history_length_)
+                    new_presses_.erase(new_presses_.begin());
+                new_presses_.push_back(event.key);
+            }
+            else if (event.state == GLFW_RELEASE && is_valid_key) {
+                held_keys_.reset((size_t)event.key);
+                const size_t last_press = last_press_[(size_t)event.key];
+                if (last_press > oldest_press_)
+                    history_[(last_press - 1) % max_history_length].event.state = GLFW_RELEASE;
             }
+            // Repeats do not complete shortcuts
         }
     }
 
+    void KeyboardShortCut::push_press(const KeyEvent& event) {
+        if (num_presses_ - oldest_press_ == max_history_length)
+            drop_oldest_press();
+        history_[num_presses_ % max_history_length] = HistoryEntry{ event, false };
+        num_presses_++;
+        num_live_presses_++;
+        while (num_live_presses_ > history_length_)
+            drop_oldest_press();
+    }
+
+    void KeyboardShortCut::drop_oldest_press() {
+        if (!history_[oldest_press_ % max_history_length].consumed)
+            num_live_presses_--;
+        oldest_press_++;
+    }
+
     void KeyboardShortCut::dispatchShortcuts() {
-        std::lock_guard<std::mutex> guard(mutex);
-
-        for (auto& shortcut : local_shortcuts_) {
-            shortcut.tmp_keys = shortcut.keys;
-            bool is_valid = is_shortcut_valid(shortcut);
-            if (is_valid) {
-                std::string event_name = std::string("shortcuts/local/") + shortcut.name;
-                eventQueue_.post(Event_ptr(new Event(event_name)));
-                if (shortcut.callback != NULL)
-                    shortcut.callback();
-            }
+        process_key_events();
+
+        const bool ignore_global_shortcuts = ignore_global_shortcuts_;
+        ignore_global_shortcuts_ = false;
+        // Nothing can be completed without a new key press
+        if (new_presses_.empty()) {
+            local_shortcuts_.clear();
+            return;
+        }
 
+        completed_local_.clear();
+        completed_global_.clear();
+        for (auto& compiled : local_shortcuts_) {
+            if (uses_new_presses(compiled) && is_shortcut_valid(compiled))
+                completed_local_.push_back(std::move(compiled));
         }
         // Local shortcuts are only dispatched once, then they are destroyed
         local_shortcuts_.clear();
-        if (ignore_global_shortcuts_) {
-            ignore_global_shortcuts_ = false;
-            return;
-        }
-        // Go through all global shortcuts
-        for (auto& shortcut : global_shortcuts_) {
-            shortcut.tmp_keys = shortcut.keys;
-            bool is_valid = is_shortcut_valid(shortcut);
-            if (is_valid) {
-                std::string event_name = std::string("shortcuts/global/") + shortcut.name;
-                eventQueue_.post(Event_ptr(new Event(event_name)));
-                if (shortcut.callback != NULL)
-                    shortcut.callback();
+
+        if (!ignore_global_shortcuts) {
+            // Only the shortcuts that use one of the new keys can have been completed
+            candidates_.clear();
+            for (auto key : new_presses_) {
+                if (isValidKey(key)) {
+                    const auto& indices = global_shortcuts_index_[(size_t)key];
+                    candidates_.insert(candidates_.end(), indices.begin(), indices.end());
+                }
             }
-        }
-    }
+            // Keeps the order in which the shortcuts have been added
+            std::sort(candidates_.begin(), candidates_.end());
+            candidates_.erase(std::unique(candidates_.begin(), candidates_.end()), candidates_.end());
 
-    std::multiset<keyboard_event>::iterator KeyboardShortCut::find_key(Shortcut& shortcut, const int key) {
-        for (auto it = shortcut.tmp_keys.begin();it != shortcut.tmp_keys.end();it++) {
-            if (*it == key)
-                return it;
-            else if (*it == KEY_CTRL && (key == GLFW_KEY_LEFT_CONTROL || key == GLFW_KEY_RIGHT_CONTROL))
-                return it;
-            else if (*it == KEY_ALT && (key == GLFW_KEY_LEFT_ALT || key == GLFW_KEY_RIGHT_ALT))
-                return it;
-            else if (*it == KEY_SHIFT && (key == GLFW_KEY_LEFT_SHIFT || key == GLFW_KEY_RIGHT_SHIFT))
-                return it;
-            else if (*it == KEY_ENTER && (key == GLFW_KEY_ENTER || key == GLFW_KEY_KP_ENTER))
-                return it;
-            else if (*it == KEY_SUPER && (key == GLFW_KEY_LEFT_SUPER || key == GLFW_KEY_RIGHT_SUPER))
-                return it;
+            for (auto index : candidates_) {
+                if (is_shortcut_valid(global_shortcuts_[index]))
+                    completed_global_.push_back(index);
+            }
         }
-        return shortcut.tmp_keys.end();
+        // The presses are only matched once: held keys and older presses in the
+        // history do not complete the shortcuts again at the next calls
+        new_presses_.clear();
+
+        // The callbacks are called once the matching is over
+        for (auto& compiled : completed_local_)
+            fire(compiled);
+        for (auto index : completed_global_)
+            fire(global_shortcuts_[index]);
     }
 
-
     // Does not work with GLFW for now
     // TODO: use native API
     void KeyboardShortCut::character_callback(GLFWwindow*, unsigned int) {
@@ -224,107 +345,76 @@ namespace Tempo {
     }
 
     int KeyboardShortCut::translate_keycode(int key) {
-        const char* keyName = glfwGetKeyName(key, GLFW_KEY_UNKNOWN);
+        if (!isValidKey(key))
+            return key;
+        if (!is_key_translation_built_)
+            rebuildKeyTranslation();
+        return key_translation_[(size_t)key];
+    }
 
-        // Register only non-named keys or numpad events
-        if (keyName != NULL && kp_keys_list_.find(key) == kp_keys_list_.end()) {
-            switch (keyName[0]) {
-            case 'a':
-                key = GLFW_KEY_A;
-                break;
-            case 'b':
-                key = GLFW_KEY_B;
-                break;
-            case 'c':
-                key = GLFW_KEY_C;
-                break;
-            case 'd':
-                key = GLFW_KEY_D;
-                break;
-            case 'e':
-                key = GLFW_KEY_E;
-                break;
-            case 'f':
-                key = GLFW_KEY_F;
-                break;
-            case 'g':
-                key = GLFW_KEY_G;
-                break;
-            case 'h':
-                key = GLFW_KEY_H;
-                break;
-            case 'i':
-                key = GLFW_KEY_I;
-                break;
-            case 'j':
-                key = GLFW_KEY_J;
-                break;
-            case 'k':
-                key = GLFW_KEY_K;
-                break;
-            case 'l':
-                key = GLFW_KEY_L;
-                break;
-            case 'm':
-                key = GLFW_KEY_M;
-                break;
-            case 'n':
-                key = GLFW_KEY_N;
-                break;
-            case 'o':
-                key = GLFW_KEY_O;
-                break;
-            case 'p':
-                key = GLFW_KEY_P;
-                break;
-            case 'q':
-                key = GLFW_KEY_Q;
-                break;
-            case 'r':
-                key = GLFW_KEY_R;
-                break;
-            case 's':
-                key = GLFW_KEY_S;
-                break;
-            case 't':
-                key = GLFW_KEY_T;
-                break;
-            case 'u':
-                key = GLFW_KEY_U;
-                break;
-            case 'v':
-                key = GLFW_KEY_V;
-                break;
-            case 'w':
-                key = GLFW_KEY_W;
-                break;
-            case 'x':
-                key = GLFW_KEY_X;
-                break;
-            case 'y':
-                key = GLFW_KEY_Y;
-                break;
-            case 'z':
-                key = GLFW_KEY_Z;
-                break;
+    void KeyboardShortCut::rebuildKeyTranslation() {
+        for (int key = 0; key <= GLFW_KEY_LAST; key++) {
+            key_translation_[(size_t)key] = key;
+            key_names_[(size_t)key].clear();
+        }
+        for (int key = 0; key <= GLFW_KEY_LAST; key++) {
+            const char* key_name = glfwGetKeyName(key, GLFW_KEY_UNKNOWN);
+            if (key_name == NULL || key_name[0] == '\0')
+                continue;
+
+            // Numpad keys and keys with a longer name (e.g. non-ASCII characters) keep their code
+            int translated = key;
+            if (kp_keys_list_.find(key) == kp_keys_list_.end() && key_name[1] == '\0') {
+                // The GLFW keys of letters, digits and punctuation are their ASCII code (upper case)
+                char c = key_name[0];
+                if (c >= 'a' && c <= 'z')
+                    translated = GLFW_KEY_A + (c - 'a');
+                else if ((c >= '0' && c <= '9') || c == '\'' || c == ',' || c == '-' || c == '.' || c == '/'
+                    || c == ';' || c == '=' || c == '[' || c == '\\' || c == ']' || c == '`')
+                    translated = (int)c;
             }
+            key_translation_[(size_t)key] = translated;
+            key_names_[(size_t)translated] = key_name;
         }
-        return key;
+        is_key_translation_built_ = true;
     }
 
     void KeyboardShortCut::addShortcut(Shortcut& shortcut) {
-        global_shortcuts_.push_back(shortcut);
+        const size_t index = global_shortcuts_.size();
+        global_shortcuts_.push_back(compile(shortcut, "shortcuts/global/"));
+        for (const auto& alternatives : global_shortcuts_.back().keys) {
+            for (auto key : alternatives) {
+                if (!isValidKey(key))
+                    continue;
+                auto& indices = global_shortcuts_index_[(size_t)key];
+                if (indices.empty() || indices.back() != index)
+                    indices.push_back(index);
+            }
+        }
     }
 
     void KeyboardShortCut::emptyKeyEventsQueue() {
-        while (!keyboard_events_.empty()) {
-            keyboard_events_.pop_front();
-        }
+        key_events_.clear();
+        clear_history();
+    }
+
+    void KeyboardShortCut::clear_history() {
+        num_presses_ = 0;
+        oldest_press_ = 0;
+        num_live_presses_ = 0;
+        last_press_.fill(0);
+        held_keys_.reset();
+        new_presses_.clear();
+    }
 
+    void KeyboardShortCut::setHistoryLength(size_t length) {
+        history_length_ = std::clamp(length, (size_t)1, max_history_length);
+        while (num_live_presses_ > history_length_)
+            drop_oldest_press();
     }
 
     void KeyboardShortCut::addTempShortcut(Shortcut& shortcut) {
-        local_shortcuts_.push_back(shortcut);
+        local_shortcuts_.push_back(compile(shortcut, "shortcuts/local/"));
     }
 
     void KeyboardShortCut::flushTempShortcuts() {
@@ -344,7 +434,11 @@ namespace Tempo {
         case KEY_ENTER:
             return "Enter";
         default:
-            return glfwGetKeyName(key, GLFW_KEY_UNKNOWN);
+            if (!isValidKey(key))
+                return "";
+            if (!KeyboardShortCut::is_key_translation_built_)
+                KeyboardShortCut::rebuildKeyTranslation();
+            return KeyboardShortCut::key_names_[(size_t)key];
         }
     }
 }
\ No newline at end of file
@@ -5,20 +5,20 @@
 #endif
 #include <GLFW/glfw3.h>
 
+#include <array>
+#include <bitset>
 #include <vector>
 #include <queue>
 #include <initializer_list>
 #include <functional>
 #include <map>
 #include <chrono>
-#include <mutex>
+#include <set>
 #include <string>
 
 #include "events.h"
-
-#ifndef KEYBOARD_SHORTCUT_QUEUE_LENGTH
-#define KEYBOARD_SHORTCUT_QUEUE_LENGTH 6
-#endif
+#include "latency.h"
+#include "ring_buffer.h"
 
 namespace Tempo {
     using keyboard_event = int;
@@ -52,12 +52,11 @@ namespace Tempo {
         // some keys are not GLFW_PRESSED
         // delay in [ms]
         float delay = 0;
-
-        std::multiset<keyboard_event> tmp_keys;
     };
 
     struct KeyEvent {
         int key;
+        // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
         int state;
         timepoint time;
     };
@@ -66,30 +65,104 @@ namespace Tempo {
     // Local, global shortcuts
     class KeyboardShortCut {
     private:
-        static std::mutex mutex;
-        static std::deque<KeyEvent> keyboard_events_;
-        static std::vector<Shortcut> global_shortcuts_;
-        static std::vector<Shortcut> local_shortcuts_;
+        // Physical keys that can satisfy a key of a shortcut (e.g. KEY_CTRL is
+        // satisfied by both control keys), -1 if there is no alternative
+        using KeyAlternatives = std::array<int, 2>;
+
+        /**
+         * Shortcut prepared for the matching, built once when the shortcut is added
+         */
+        struct CompiledShortcut {
+            Shortcut shortcut;
+            // Keys of the shortcut, in the order of the multiset
+            std::vector<KeyAlternatives> keys;
+            std::string event_name;
+        };
+
+        /**
+         * Key press kept in the history for the matching of the shortcuts
+         */
+        struct HistoryEntry {
+            KeyEvent event;
+            // The press has been taken by a completed shortcut
+            bool consumed = false;
+        };
+
+        static constexpr size_t max_history_length = 64;
+
+        // Filled by key_callback, drained by dispatchShortcuts
+        static SPSCRingBuffer<KeyEvent, 256> key_events_;
+
+        // The following members are only used by the thread calling dispatchShortcuts
+        // Press number n is stored in history_[n % max_history_length]
+        static std::array<HistoryEntry, max_history_length> history_;
+        static size_t num_presses_;
+        // Number of the oldest press still in the history, and number of presses
+        // in the history which have not been consumed (at most history_length_)
+        static size_t oldest_press_;
+        static size_t num_live_presses_;
+        static size_t history_length_;
+        // For each key, number of its last press + 1 (0 if the key has never been pressed)
+        static std::array<size_t, GLFW_KEY_LAST + 1> last_press_;
+
+        static std::vector<CompiledShortcut> global_shortcuts_;
+        static std::vector<CompiledShortcut> local_shortcuts_;
+        // For each physical key, indices of the global shortcuts that use the key
+        static std::vector<std::vector<size_t>> global_shortcuts_index_;
         static EventQueue& eventQueue_;
 
+        // Keys currently held down
+        static std::bitset<GLFW_KEY_LAST + 1> held_keys_;
+        // Keys pressed since the last call of dispatchShortcuts()
+        static std::vector<int> new_presses_;
+        static std::vector<size_t> candidates_;
+        // Shortcuts completed during the matching, fired once the matching is over
+        static std::vector<size_t> completed_global_;
+        static std::vector<CompiledShortcut> completed_local_;
+
         static bool ignore_global_shortcuts_;
 
         static std::set<int> kp_keys_list_;
         //static std::set<char> authorized_chars_;
         static GLFWkeyfun prev_key_callback_;
 
-        static bool is_shortcut_valid(Shortcut& shortcut);
-        static std::multiset<keyboard_event>::iterator find_key(Shortcut& shortcut, const int key);
+        // Logical key of each GLFW key in the current keyboard layout,
+        // and name of each logical key
+        static std::array<int, GLFW_KEY_LAST + 1> key_translation_;
+        static std::array<std::string, GLFW_KEY_LAST + 1> key_names_;
+        static bool is_key_translation_built_;
+
+        static void process_key_events();
+        static void push_press(const KeyEvent& event);
+        static void drop_oldest_press();
+        static void clear_history();
+        static CompiledShortcut compile(const Shortcut& shortcut, const std::string& prefix);
+        static bool is_held(const CompiledShortcut& compiled);
+        static bool uses_new_presses(const CompiledShortcut& compiled);
+        static bool is_shortcut_valid(const CompiledShortcut& compiled);
+        static void fire(CompiledShortcut& compiled);
     public:
         static int last_keystroke_;
         // GLFW does not understand keyboard layouts
         // If a user pressed the key "z", depending on the keyboard layout,
         // it could send an GLFW_KEY_Z or GLFW_KEY_Y or else.
-        // We try to hack key_callback to do the right thing, but
-        // still no support for other than A-Z keys
+        // key_callback translates the keys with a table built from the names of the
+        // keys in the current layout (letters, digits and punctuation)
 
+        /**
+         * @return logical key corresponding to the GLFW key in the current keyboard layout
+         */
         static int translate_keycode(int key);
 
+        /**
+         * @brief Rebuilds the translation table of the keys from the current keyboard layout
+         *
+         * The table is built at the first translation, and rebuilt each time a window
+         * of the application gains the focus (the layout is usually changed outside
+         * of the application). Call this function if the layout can change otherwise.
+         */
+        static void rebuildKeyTranslation();
+
         /**
          * For one dispatchShortcuts() call, the list of shortcuts (i.e. not temporary) is not processed
          * Allows to make temporary shortcuts to take control of the listened shortcuts
@@ -118,6 +191,10 @@ namespace Tempo {
         /**
          * Key callback to be defined for any newly created window
          *
+         * The callback only timestamps the event and pushes it to a lock-free queue,
+         * which is processed by dispatchShortcuts(). If more than 256 key events
+         * arrive between two dispatches, the extra events are dropped.
+         *
          * @note character_callback must be called first in order capture
          * the right key stroke
          */
@@ -135,12 +212,32 @@ namespace Tempo {
          */
         static void emptyKeyEventsQueue();
 
+        /**
+         * @brief Sets the number of key presses remembered to complete a shortcut
+         * (default: 6, see Config::shortcut_history_length)
+         *
+         * @param length number of presses, clamped between 1 and 64
+         */
+        static void setHistoryLength(size_t length);
+
         /**
          * Processes the queue for global and local shortcuts
          * Should be called once per loop in the main loop
+         *
+         * A shortcut can only be completed by a key press: if no key has been pressed
+         * since the last call, the function returns immediately. Otherwise, only the
+         * shortcuts which use one of the pressed keys are matched against the history.
+         *
+         * The callbacks of the completed shortcuts are called once the matching is over,
+         * so they can safely add new shortcuts.
          */
         static void dispatchShortcuts();
+        friend std::string getKeyName(int key);
     };
 
+    /**
+     * @return name of the logical key in the current keyboard layout (e.g. "Ctrl", "z"),
+     * empty if the key has no name
+     */
     std::string getKeyName(int key);
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <imgui.h>
+
+namespace Tempo {
+    namespace {
+        using clock = std::chrono::steady_clock;
+
+        LatencyPercentiles computePercentiles(std::vector<std::chrono::nanoseconds>& values) {
+            LatencyPercentiles percentiles;
+            if (values.empty())
+                return percentiles;
+            auto at = [&values](float p) {
+                size_t index = (size_t)(p * (float)(values.size() - 1));
+                std::nth_element(values.begin(), values.begin() + (std::ptrdiff_t)index, values.end());
+                return std::chrono::duration_cast<std::chrono::microseconds>(values[index]);
+            };
+            percentiles.p50 = at(0.5f);
+            percentiles.p95 = at(0.95f);
+            percentiles.p99 = at(0.99f);
+            percentiles.max = at(1.f);
+            return percentiles;
+        }
+    }
+
+    const char* getLatencyStageName(latencyStage stage) {
+        switch (stage) {
+        case LATENCY_STAGE_WAIT:
+            return "Wait";
+        case LATENCY_STAGE_BEFORE_FRAME:
+            return "Before frame";
+        case LATENCY_STAGE_FRAME_UPDATE:
+            return "Frame update";
+        case LATENCY_STAGE_RENDER:
+            return "Render";
+        case LATENCY_STAGE_PRESENT:
+            return "Present";
+        default:
+            return "";
+        }
+    }
+
+    void InputLatencyTracker::setEnabled(bool enabled) {
+        enabled_.store(enabled);
+        if (!enabled) {
+            pending_input_.store(0);
+            in_frame_ = false;
+            frame_input_.reset();
+        }
+    }
+
+    void InputLatencyTracker::recordInput() {
+        if (!enabled_.load(std::memory_order_relaxed))
+            return;
+        long long now = clock::now().time_since_epoch().count();
+        long long expected = 0;
+        // Keeps the oldest input of the frame
+        pending_input_.compare_exchange_strong(expected, now);
+    }
+
+    void InputLatencyTracker::beginFrame() {
+        frame_input_.reset();
+        in_frame_ = false;
+        if (!enabled_.load(std::memory_order_relaxed))
+            return;
+        long long input = pending_input_.exchange(0);
+        if (input == 0)
+            return;
+
+        const auto input_time = clock::time_point(clock::duration(input));
+        const auto now = clock::now();
+        frame_input_ = input_time;
+        in_frame_ = true;
+        current_.stages.fill(std::chrono::nanoseconds(0));
+        current_.stages[LATENCY_STAGE_WAIT] = now - input_time;
+        stage_start_ = now;
+    }
+
+    void InputLatencyTracker::endStage(latencyStage stage) {
+        // e.g. frames rendered from the resize callback, or frames without input
+        if (!in_frame_ || stage == LATENCY_STAGE_WAIT || stage >= LATENCY_STAGE_COUNT)
+            return;
+        const auto now = clock::now();
+        current_.stages[stage] += now - stage_start_;
+        stage_start_ = now;
+        if (stage != LATENCY_STAGE_PRESENT)
+            return;
+
+        current_.total = now - *frame_input_;
+        in_frame_ = false;
+        std::lock_guard<std::mutex> guard(samples_mutex_);
+        if (samples_.size() < max_samples) {
+            samples_.push_back(current_);
+        }
+        else {
+            samples_[next_sample_] = current_;
+            next_sample_ = (next_sample_ + 1) % max_samples;
+        }
+    }
+
+    void InputLatencyTracker::skipPresent() {
+        if (!in_frame_)
+            return;
+        in_frame_ = false;
+        // Keeps the oldest input, inputs may have been recorded during the frame
+        const long long input = frame_input_->time_since_epoch().count();
+        long long pending = pending_input_.load();
+        while ((pending == 0 || input < pending) && !pending_input_.compare_exchange_weak(pending, input)) {
+        }
+    }
+
+    InputLatencyStats InputLatencyTracker::getStats() const {
+        InputLatencyStats stats;
+        std::vector<std::chrono::nanoseconds> values;
+        std::lock_guard<std::mutex> guard(samples_mutex_);
+        stats.samples = samples_.size();
+        values.reserve(samples_.size());
+
+        for (const auto& sample : samples_)
+            values.push_back(sample.total);
+        stats.total = computePercentiles(values);
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            values.clear();
+            for (const auto& sample : samples_)
+                values.push_back(sample.stages[stage]);
+            stats.stages[stage] = computePercentiles(values);
+        }
+        return stats;
+    }
+
+    void InputLatencyTracker::reset() {
+        std::lock_guard<std::mutex> guard(samples_mutex_);
+        samples_.clear();
+        next_sample_ = 0;
+    }
+
+    void ShowInputLatencyOverlay(bool* p_open) {
+        auto& tracker = InputLatencyTracker::getInstance();
+        const auto stats = tracker.getStats();
+
+        const ImGuiViewport* viewport = ImGui::GetMainViewport();
+        ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - 10.f, viewport->WorkPos.y + 10.f), ImGuiCond_Always, ImVec2(1.f, 0.f));
+        ImGui::SetNextWindowViewport(viewport->ID);
+        ImGui::SetNextWindowBgAlpha(0.7f);
+        const ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings
+            | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+        if (ImGui::Begin("Input latency", p_open, flags)) {
+            auto ms = [](std::chrono::microseconds us) { return (double)us.count() / 1000.; };
+            ImGui::Text("Input to present (%d frames)", (int)stats.samples);
+            if (!tracker.isEnabled())
+                ImGui::TextDisabled("Measurement disabled");
+            ImGui::Separator();
+            ImGui::Text("%-13s %7s %7s %7s %7s", "ms", "p50", "p95", "p99", "max");
+            ImGui::Text("%-13s %7.2f %7.2f %7.2f %7.2f", "Total",
+                ms(stats.total.p50), ms(stats.total.p95), ms(stats.total.p99), ms(stats.total.max));
+            for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+                const auto& percentiles = stats.stages[stage];
+                ImGui::Text("%-13s %7.2f %7.2f %7.2f %7.2f", getLatencyStageName((latencyStage)stage),
+                    ms(percentiles.p50), ms(percentiles.p95), ms(percentiles.p99), ms(percentiles.max));
+            }
+        }
+        ImGui::End();
+    }
+}
\ No newline at end of file
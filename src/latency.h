@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Tempo {
+    /**
+     * Stages of a frame between an input and the presentation of the frame
+     */
+    enum latencyStage {
+        LATENCY_STAGE_WAIT,         // From the input to the start of the frame
+        LATENCY_STAGE_BEFORE_FRAME, // Events, shortcuts, BeforeFrameUpdate and fonts
+        LATENCY_STAGE_FRAME_UPDATE, // FrameUpdate and ImGui::Render
+        LATENCY_STAGE_RENDER,       // OpenGL rendering of all the viewports
+        LATENCY_STAGE_PRESENT,      // glfwSwapBuffers
+        LATENCY_STAGE_COUNT
+    };
+
+    /**
+     * @return name of the stage, for display
+     */
+    const char* getLatencyStageName(latencyStage stage);
+
+    struct LatencyPercentiles {
+        std::chrono::microseconds p50{ 0 };
+        std::chrono::microseconds p95{ 0 };
+        std::chrono::microseconds p99{ 0 };
+        std::chrono::microseconds max{ 0 };
+    };
+
+    /**
+     * Input-to-present latency, over the last measured frames
+     */
+    struct InputLatencyStats {
+        size_t samples = 0;
+        LatencyPercentiles total;
+        LatencyPercentiles stages[LATENCY_STAGE_COUNT];
+    };
+
+    /**
+     * @brief Measures the time between an input (key, mouse) and the moment the frame
+     * which processed the input has been presented (glfwSwapBuffers returned)
+     *
+     * The GLFW callbacks timestamp the inputs with recordInput(). The main loop marks the
+     * beginning of the frame and the end of each stage. Only frames which processed an
+     * input are measured; when multiple inputs are processed by the same frame, the
+     * oldest one is used. The input of a frame which is not presented (skipped) is
+     * measured by the next presented frame.
+     *
+     * The tracker is disabled by default (see Config::measure_input_latency)
+     */
+    class InputLatencyTracker {
+    private:
+        static constexpr size_t max_samples = 1024;
+
+        struct Sample {
+            std::chrono::nanoseconds total;
+            std::array<std::chrono::nanoseconds, LATENCY_STAGE_COUNT> stages;
+        };
+
+        std::atomic<bool> enabled_{ false };
+        // Oldest input not processed yet (ns of the steady clock), 0 if there is none
+        std::atomic<long long> pending_input_{ 0 };
+
+        // State of the current frame, only used by the main thread
+        bool in_frame_ = false;
+        std::optional<std::chrono::steady_clock::time_point> frame_input_;
+        std::chrono::steady_clock::time_point stage_start_;
+        Sample current_;
+
+        std::vector<Sample> samples_;
+        size_t next_sample_ = 0;
+        mutable std::mutex samples_mutex_;
+
+        InputLatencyTracker() = default;
+
+    public:
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        InputLatencyTracker(InputLatencyTracker const&) = delete;
+        void operator=(InputLatencyTracker const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the InputLatencyTracker
+         */
+        static InputLatencyTracker& getInstance() {
+            static InputLatencyTracker instance;
+            return instance;
+        }
+
+        void setEnabled(bool enabled);
+        bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        /**
+         * Timestamps an input, to be called from the input callbacks (thread-safe)
+         */
+        void recordInput();
+
+        /**
+         * Starts the measurement of a frame, called by the main loop once the inputs have been received
+         */
+        void beginFrame();
+
+        /**
+         * Marks the end of a stage of the current frame, called by the main loop
+         * The frame is measured once LATENCY_STAGE_PRESENT has ended
+         */
+        void endStage(latencyStage stage);
+
+        /**
+         * Ends the current frame without measuring it, because it has not been presented
+         * (e.g. identical to the previous frame). Its input is measured by the next presented frame
+         */
+        void skipPresent();
+
+        /**
+         * @return time of the oldest input processed by the current frame, if any
+         * (can be used in BeforeFrameUpdate or FrameUpdate)
+         */
+        std::optional<std::chrono::steady_clock::time_point> getFrameInputTime() const {
+            return frame_input_;
+        }
+
+        /**
+         * @return percentiles of the latency over the last 1024 measured frames
+         */
+        InputLatencyStats getStats() const;
+
+        /**
+         * Forgets all the measured frames
+         */
+        void reset();
+    };
+
+    /**
+     * Shows a small ImGui window with the percentiles of the input latency
+     * Should be called between ImGui::NewFrame and ImGui::Render
+     * @param p_open see ImGui::Begin
+     */
+    void ShowInputLatencyOverlay(bool* p_open = nullptr);
+}
\ No newline at end of file
@@ -5,22 +5,24 @@
 
 namespace Tempo {
 	DebugLogger::DebugLogger(const std::string& out, bool print_std) : m_out_file(out), m_print_std(print_std) {
-		m_event_listener.callback = [=](Event_ptr& event) {
+		m_event_listener.callback = [=](const LogEvent& event) {
 			if (m_print_std) {
-				auto log = LOGEVENT_PTRCAST(event.get());
-				std::cout << log->getMessage() << std::endl;
+				std::cout << event.getMessage() << std::endl;
 			}
 		};
 		m_event_listener.filter = "log/debug";
 
-		EventQueue::getInstance().subscribe(&m_event_listener);
+		EventChannel<LogEvent>::getInstance().subscribe(&m_event_listener);
 	}
 
 	DebugLogger::~DebugLogger() {
-		EventQueue::getInstance().unsubscribe(&m_event_listener);
+		EventChannel<LogEvent>::getInstance().unsubscribe(&m_event_listener);
 	}
 
 	void debug_event(const std::string&, const std::string& func, const std::string& str) {
-		EventQueue::getInstance().post(Event_ptr(new LogEvent("debug", "[" + func + "] " + str)));
+		std::string message = "[" + func + "] " + str;
+		// Deprecated path, for the listeners of the EventQueue (removed in the next release)
+		EventQueue::getInstance().post(MakeEvent<LogEvent>("debug", message));
+		EventChannel<LogEvent>::getInstance().post("debug", std::move(message));
 	}
 }
\ No newline at end of file
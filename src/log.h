@@ -4,7 +4,7 @@
 #include <string>
 #include <utility>
 
-#include "events.h"
+#include "event_channel.h"
 
 namespace Tempo {
     /**
@@ -15,18 +15,33 @@ namespace Tempo {
         std::string m_message;
 
     public:
-        explicit LogEvent(const std::string& name, std::string message) : Event(std::string("log/") + name), m_message(std::move(message)) {}
+        explicit LogEvent(const std::string& name, std::string message) : Event(std::string("log/") + name, false, EVENT_PRIORITY_LOW), m_message(std::move(message)) {}
 
-        std::string& getMessage() { return m_message; }
+        const std::string& getMessage() const { return m_message; }
+
+        size_t getSize() const override { return sizeof(LogEvent) + name_.size() + m_message.size(); }
+    };
+
+    /**
+     * @deprecated Log events are posted in EventChannel<LogEvent>, whose listeners receive
+     * a const LogEvent&. They are still posted in the EventQueue until the next release
+     */
+    [[deprecated("Subscribe to EventChannel<LogEvent> instead")]]
+    inline LogEvent* log_event_cast(Event* event) { return static_cast<LogEvent*>(event); }
+#define LOGEVENT_PTRCAST(job) (::Tempo::log_event_cast((job)))
+
+    // Logs should never delay the input handling
+    template <>
+    struct EventChannelTraits<LogEvent> {
+        static constexpr Event::eventPriority priority = Event::EVENT_PRIORITY_LOW;
     };
-#define LOGEVENT_PTRCAST(job) (reinterpret_cast<LogEvent*>((job)))
 
     class DebugLogger {
     private:
         std::vector<std::string> m_logs;
         std::string m_out_file;
         bool m_print_std;
-        Listener m_event_listener;
+        TypedListener<LogEvent> m_event_listener;
 
     public:
         DebugLogger(const std::string& out, bool print_std = false);
@@ -0,0 +1,109 @@
+#include "mapped_file.h"
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Tempo {
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path) {
+        file_handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_handle_ == INVALID_HANDLE_VALUE) {
+            file_handle_ = nullptr;
+            throw MappedFileException("Cannot open " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_handle_, &size)) {
+            close();
+            throw MappedFileException("Cannot read the size of " + path);
+        }
+        size_ = (size_t)size.QuadPart;
+        // Empty files cannot be mapped
+        if (size_ == 0)
+            return;
+        mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle_ != nullptr)
+            data_ = (const unsigned char*)MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0);
+        if (data_ == nullptr) {
+            close();
+            throw MappedFileException("Cannot map " + path);
+        }
+    }
+
+    void MappedFile::close() {
+        if (data_ != nullptr)
+            UnmapViewOfFile(data_);
+        if (mapping_handle_ != nullptr)
+            CloseHandle(mapping_handle_);
+        if (file_handle_ != nullptr)
+            CloseHandle(file_handle_);
+        data_ = nullptr;
+        mapping_handle_ = nullptr;
+        file_handle_ = nullptr;
+        size_ = 0;
+    }
+#else
+    MappedFile::MappedFile(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0)
+            throw MappedFileException("Cannot open " + path);
+        struct stat file_stat;
+        if (fstat(fd_, &file_stat) != 0) {
+            close();
+            throw MappedFileException("Cannot read the size of " + path);
+        }
+        size_ = (size_t)file_stat.st_size;
+        // Empty files cannot be mapped
+        if (size_ == 0)
+            return;
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED) {
+            close();
+            throw MappedFileException("Cannot map " + path);
+        }
+        data_ = (const unsigned char*)data;
+    }
+
+    void MappedFile::close() {
+        if (data_ != nullptr)
+            munmap((void*)data_, size_);
+        if (fd_ >= 0)
+            ::close(fd_);
+        data_ = nullptr;
+        fd_ = -1;
+        size_ = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    FileStamp getFileStamp(const std::string& path) {
+        FileStamp stamp;
+        struct stat file_stat;
+        if (stat(path.c_str(), &file_stat) != 0)
+            return stamp;
+        stamp.exists = true;
+        stamp.size = (uint64_t)file_stat.st_size;
+        stamp.modification_time = (int64_t)file_stat.st_mtime;
+        return stamp;
+    }
+
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+}
\ No newline at end of file
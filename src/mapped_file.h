@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <utility>
+
+namespace Tempo {
+    /**
+     * Exceptions related to memory-mapped files (e.g. file cannot be opened or mapped)
+     */
+    class MappedFileException : public std::exception {
+    private:
+        std::string what_;
+
+    public:
+        explicit MappedFileException(std::string what) : what_(std::move(what)) {}
+        const char* what() const noexcept override {
+            return what_.c_str();
+        }
+    };
+
+    /**
+     * @brief Read-only view of a whole file, mapped in memory
+     *
+     * The pages are loaded by the OS on first access, and shared with the
+     * page cache, so mapping a file does not copy it. The mapping stays valid
+     * as long as the object lives.
+     *
+     * @code{.cpp}
+     * MappedFile file("fonts/Roboto-Regular.ttf");
+     * uint64_t hash = hashBytes(file.data(), file.size());
+     * @endcode
+     */
+    class MappedFile {
+    private:
+        const unsigned char* data_ = nullptr;
+        size_t size_ = 0;
+#ifdef _WIN32
+        void* file_handle_ = nullptr;
+        void* mapping_handle_ = nullptr;
+#else
+        int fd_ = -1;
+#endif
+
+        void close();
+
+    public:
+        /**
+         * Maps the file
+         * @param path path of the file
+         * @throws MappedFileException if the file cannot be opened or mapped
+         */
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        void operator=(MappedFile const&) = delete;
+
+        const unsigned char* data() const { return data_; }
+        size_t size() const { return size_; }
+    };
+
+    /**
+     * Size and last modification time of a file, to detect changes without reading it
+     */
+    struct FileStamp {
+        uint64_t size = 0;
+        int64_t modification_time = 0;
+        bool exists = false;
+    };
+
+    /**
+     * @return size and modification time of the file (exists is false if it cannot be found)
+     */
+    FileStamp getFileStamp(const std::string& path);
+
+    /**
+     * @brief 64 bits FNV-1a hash of some bytes
+     * @param seed previous hash, to hash multiple buffers one after the other
+     */
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ULL);
+}
\ No newline at end of file
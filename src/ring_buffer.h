@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Tempo {
+    /**
+     * @brief Fixed-capacity lock-free ring buffer, for one producer thread and one consumer thread
+     *
+     * Neither push() nor pop() allocate or lock. When the buffer is full, push()
+     * fails and the value is dropped.
+     *
+     * @tparam T type of the values (copied in and out of the buffer)
+     * @tparam Capacity maximum number of values, must be a power of two
+     */
+    template <typename T, size_t Capacity>
+    class SPSCRingBuffer {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    private:
+        std::array<T, Capacity> buffer_{};
+        // Next position to write (only written by the producer)
+        alignas(64) std::atomic<size_t> head_{ 0 };
+        // Next position to read (only written by the consumer)
+        alignas(64) std::atomic<size_t> tail_{ 0 };
+
+    public:
+        /**
+         * Adds a value to the buffer (producer side)
+         * @return false if the buffer is full
+         */
+        bool push(const T& value) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) == Capacity)
+                return false;
+            buffer_[head & (Capacity - 1)] = value;
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Removes the oldest value of the buffer (consumer side)
+         * @return false if the buffer is empty
+         */
+        bool pop(T& value) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire))
+                return false;
+            value = buffer_[tail & (Capacity - 1)];
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Drops all the values currently in the buffer (consumer side)
+         */
+        void clear() {
+            tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        /**
+         * @return approximate number of values in the buffer
+         */
+        size_t size() const {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        static constexpr size_t capacity() {
+            return Capacity;
+        }
+    };
+}
\ No newline at end of file
@@ -47,6 +47,7 @@ namespace Tempo {
     void PollUntil(long long milliseconds) {
         app_state.poll_until = std::chrono::steady_clock::now()
             + std::chrono::milliseconds(milliseconds);
+        FramePacer::getInstance().keepActiveUntil(app_state.poll_until);
     }
 
     void SkipFrame() {
@@ -55,6 +56,16 @@ namespace Tempo {
 
     void SetVSync(int interval) {
         glfwSwapInterval(interval);
+        app_state.vsync = interval > 0;
+        FramePacer::getInstance().setVSync(interval > 0);
+    }
+
+    void SetTargetFPS(double fps) {
+        FramePacer::getInstance().setTargetFps(fps);
+    }
+
+    FramePacerStats GetFramePacerStats() {
+        return FramePacer::getInstance().getStats();
     }
 
     float GetScaling() {
@@ -64,22 +75,15 @@ namespace Tempo {
     void PushAnimation(const std::string& name, long long int duration) {
         if (app_state.animations.count(name))
             return;
-        app_state.animations[name] = Animation{
-            std::chrono::steady_clock::now(),
-            duration
-        };
+        app_state.animations[name] = Animation{ StartTween(0.f, 1.f, duration) };
     }
 
     float GetProgress(const std::string& name) {
-        if (!app_state.animations.count(name)) {
+        auto it = app_state.animations.find(name);
+        if (it == app_state.animations.end()) {
             return 1.f;
         }
-        auto now = std::chrono::steady_clock::now();
-        return min(
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - app_state.animations[name].tp).count()
-            / (float)app_state.animations[name].duration,
-            1.f);
+        return GetTweenProgress(it->second.tween);
     }
 
     int Run(App* application, Config config) {
@@ -142,7 +146,8 @@ namespace Tempo {
         );
 
         glfwMakeContextCurrent(main_window);
-        glfwSwapInterval(1);  // Enable vsync
+        glfwSwapInterval(config.vsync ? 1 : 0);
+        app_state.vsync = config.vsync;
 
         // Initialize OpenGL loader
         gladLoadGL();
@@ -153,7 +158,8 @@ namespace Tempo {
 
         // Setup Dear ImGui context
         IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
+        // The font atlas is owned by the FontManager, which swaps it when fonts are rebuilt
+        ImGui::CreateContext(FONTM.getAtlas());
 
         ImGuiIO& io = ImGui::GetIO();
         (void)io;
@@ -162,6 +168,7 @@ namespace Tempo {
         // Setup Platform/Renderer bindings
         ImGui_ImplGlfw_InitForOpenGL(main_window, true);
         ImGui_ImplOpenGL3_Init(app_state.glsl_version);
+        ImGui_ImplOpenGL3_SetSingleChannelFontAtlas(config.single_channel_font_atlas);
 
         // Hack to make the ImGui windows look like normal windows
         ImGuiStyle& style = ImGui::GetStyle();
@@ -190,14 +197,47 @@ namespace Tempo {
             }
             };
         event_queue.subscribe(&tempo_listener);
+        event_queue.setDispatchBudget(std::chrono::microseconds((long long)(config.event_dispatch_budget * 1000.)));
+        // Events posted from other threads wake up glfwWaitEvents (at most once per frame)
+        // Logs are not urgent, they are dispatched with the next frame
+        event_queue.setWakeupCallback([]() { glfwPostEmptyEvent(); });
+        event_queue.setWakeup("log*", false);
+
+        std::unique_ptr<EventTraceRecorder> trace_recorder;
+        if (!config.event_trace_file.empty()) {
+            try {
+                trace_recorder = std::make_unique<EventTraceRecorder>(event_queue, config.event_trace_file);
+            }
+            catch (const EventTraceException& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
 
         /* ==== Other configs  ==== */
         GLFWwindowHandler::addWindow(main_window, 0, true);
         GLFWwindowHandler::focus_all = config.viewports_focus_all;
+        KeyboardShortCut::setHistoryLength(config.shortcut_history_length);
+        InputLatencyTracker& latency_tracker = InputLatencyTracker::getInstance();
+        latency_tracker.setEnabled(config.measure_input_latency || config.show_latency_overlay);
+        app_state.show_latency_overlay = config.show_latency_overlay;
+        app_state.skip_identical_frames = config.skip_identical_frames;
+        app_state.damage_tracking = config.damage_tracking;
         GLFWwindowHandler::application = application;
 
         app_state.app_initialized = true;
         application->m_glfw_poll_or_wait = config.poll_or_wait;
+        FramePacer& frame_pacer = FramePacer::getInstance();
+        TweenEngine& tween_engine = TweenEngine::getInstance();
+        DeadlineRegistry& deadlines = DeadlineRegistry::getInstance();
+        deadlines.setWakeupCallback([]() { glfwPostEmptyEvent(); });
+        // The text cursor blinks (ImGui shows it 0.8s, hides it 0.4s) without rendering continuously
+        const auto cursor_blink_interval = std::chrono::milliseconds(100);
+        DeadlineID cursor_blink = 0;
+        frame_pacer.setTargetFps(config.target_fps);
+        frame_pacer.setVSync(config.vsync);
+        frame_pacer.setAlwaysActive(config.poll_or_wait == Config::POLL);
+        frame_pacer.setActiveTime(std::chrono::duration_cast<FramePacer::clock::duration>(
+            std::chrono::duration<double>(config.active_time)));
 
         application->InitializationBeforeLoop();
 
@@ -205,131 +245,81 @@ namespace Tempo {
         app_state.wait_timeout = config.wait_timeout;
 
         app_state.global_scaling = 0;
+        FONTM.build_in_background = config.build_fonts_in_background;
+        if (config.cache_font_atlas)
+            FONTM.cache_path = nameToFontCacheFile(config.app_name);
+        // Fonts are built at once for the scales of all the connected monitors
+        int monitors_count = 0;
+        GLFWmonitor** glfw_monitors = glfwGetMonitors(&monitors_count);
+        for (int n = 0; n < monitors_count; n++) {
+            float x_scale, y_scale;
+            glfwGetMonitorContentScale(glfw_monitors[n], &x_scale, &y_scale);
+            FONTM.addScale(x_scale);
+        }
         /* ==== Main loop  ==== */
         do {
             io = ImGui::GetIO();
             (void)io;
 
+            // Renders at the target rate while active, waits for the events otherwise
+            // Tweens started during the last frame keep the loop active until they end
+            if (tween_engine.running() > 0)
+                frame_pacer.keepActiveUntil(tween_engine.endTime());
+            const GLFWvidmode* video_mode = glfwGetVideoMode(getCurrentMonitor(main_window));
+            frame_pacer.setRefreshRate(video_mode != nullptr ? video_mode->refreshRate : 0);
+            frame_pacer.waitForNextFrame(app_state.wait_timeout, deadlines.next());
+
             auto now = std::chrono::steady_clock::now();
+            // Tasks and timers whose deadline has passed
+            deadlines.runDue(now);
 
-            if (application->m_glfw_poll_or_wait == Config::POLL)
-                glfwPollEvents();
-            else {
-                if (std::chrono::duration_cast<std::chrono::milliseconds>(app_state.poll_until - now).count() > 0) {
-                    glfwPollEvents();
-                }
-                else {
-                    if (app_state.wait_timeout > 0.)
-                        glfwWaitEventsTimeout(app_state.wait_timeout);
-                    else
-                        glfwWaitEvents();
-                }
-            }
+            latency_tracker.beginFrame();
 
             event_queue.pollEvents();
+            // Events carried over because of the dispatch budget must be polled at the next frame
+            if (event_queue.getQueueDepth() > 0)
+                app_state.redraw = true;
             KeyboardShortCut::dispatchShortcuts();
 
             // Animation update
-            std::vector<std::string> to_remove;
-            for (auto& pair : app_state.animations) {
-                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - pair.second.tp).count();
-                if (duration > pair.second.duration)
-                    to_remove.push_back(pair.first);
-            }
-            for (auto& str : to_remove) {
-                app_state.animations.erase(str);
+            tween_engine.update(now);
+            for (auto it = app_state.animations.begin(); it != app_state.animations.end();) {
+                if (!tween_engine.isRunning(it->second.tween)) {
+                    tween_engine.release(it->second.tween);
+                    it = app_state.animations.erase(it);
+                }
+                else {
+                    it++;
+                }
             }
 
             app_state.before_frame = true;
 
             application->BeforeFrameUpdate();
 
-            // FIXME: multi-DPI system
-            // right now, we are use the main window content scale
-            // the code below is a WIP for multi-DPI
-
-            // Look for the scaling on each monitor
-            // and change fonts if there is some change
-            // int monitors_count = 0;
-            // GLFWmonitor** glfw_monitors = glfwGetMonitors(&monitors_count);
-            // if (app_state.monitors_scales.size() != monitors_count)
-            //     change_fonts = true;
-
-            // app_state.monitors_scales.resize(monitors_count);
-            // for (int n = 0;n < monitors_count; n++) {
-            //     float x_scale, y_scale;
-            //     glfwGetMonitorContentScale(glfw_monitors[n], &x_scale, &y_scale);
-            //     if (app_state.monitors_scales[n] != x_scale) {
-            //         change_fonts = true;
-            //     }
-            //     app_state.monitors_scales[n] = x_scale;
-            // }
+            // Fonts exist for the scale of every monitor that has been seen,
+            // the atlas is only rebuilt when a new scale appears (or fonts change)
+            for (const auto& monitor : ImGui::GetPlatformIO().Monitors) {
+                FONTM.addScale(monitor.DpiScale);
+            }
 
             float global_xscale, yscale;
             glfwGetWindowContentScale(main_window, &global_xscale, &yscale);
             if (global_xscale != app_state.global_scaling) {
-                FONTM.reconstruct_fonts = true;
                 app_state.global_scaling = global_xscale;
-            }
-
-            if (FONTM.reconstruct_fonts) {
-                io.Fonts->Clear();
-                // For each font, we need one FontTexture per scale
-                for (auto& font_pair : FONTM.font_atlas) {
-                    FontInfo& font = font_pair.second;
-                    // Render all previous fonts null
-                    for (auto pair : font.multi_scale_font) {
-                        pair.second->im_font = nullptr;
-                    }
-                    font.multi_scale_font.clear();
-
-                    float xscale = global_xscale;
-                    if (font.no_dpi) {
-                        xscale = 1.f;
-                    }
-
-                    float size = xscale * font.size_pixels;
-                    ImFont* imfont;
-
-                    if (font.glyph_ranges.empty())
-                        imfont = io.Fonts->AddFontFromFileTTF(font.filename.c_str(), size, &font.font_cfg);
-                    else {
-                        imfont = io.Fonts->AddFontFromFileTTF(font.filename.c_str(), size, &font.font_cfg, &font.glyph_ranges[0]);
-                    }
-
-                    font.multi_scale_font[xscale] = std::make_shared<SafeImFont>(SafeImFont{ imfont });
-
-                    for (auto& icon_font : font.icons) {
-                        ImFontConfig cfg = icon_font.font_cfg;
-                        cfg.GlyphOffset = ImVec2(xscale * cfg.GlyphOffset.x, xscale * cfg.GlyphOffset.y);
-                        cfg.GlyphExtraSpacing = ImVec2(xscale * cfg.GlyphExtraSpacing.x, xscale * cfg.GlyphExtraSpacing.y);
-                        cfg.GlyphMaxAdvanceX = xscale * cfg.GlyphMaxAdvanceX;
-                        cfg.GlyphMinAdvanceX = xscale * cfg.GlyphMinAdvanceX;
-                        if (icon_font.glyph_ranges.empty())
-                            io.Fonts->AddFontFromFileTTF(
-                                icon_font.filename.c_str(),
-                                size, &cfg);
-                        else
-                            io.Fonts->AddFontFromFileTTF(
-                                icon_font.filename.c_str(),
-                                size, &cfg, &icon_font.glyph_ranges[0]);
-                    }
+                FONTM.main_scale = global_xscale;
+                FONTM.addScale(global_xscale);
 #ifdef __APPLE__
-                    io.FontGlobalScale = 1.f / xscale;
+                // Coordinates are in points, the fonts are rasterized at the pixel size
+                io.FontGlobalScale = 1.f / global_xscale;
 #endif
-
-                    // For multi-DPI
-                    // for (auto& scale : app_state.monitors_scales) {
-                    //     ImFont* imfont = io.Fonts->AddFontFromFileTTF(font.filename.c_str(), scale * font.size_pixels, font.font_cfg, font.glyph_ranges);
-                    //     font.multi_scale_font[scale] = imfont;
-                    // }
-                }
-                io.Fonts->Build();
-                ImGui_ImplOpenGL3_DestroyFontsTexture();
-                ImGui_ImplOpenGL3_CreateFontsTexture();
             }
 
-            FONTM.reconstruct_fonts = false;
+            // Glyphs requested during the frame are rasterized at the next update
+            FONTM.glyph_cache.newFrame();
+
+            // New fonts are added in pages, other changes rebuild the atlas
+            FONTM.update();
 
             // ImGuiPlatformIO& platorm_io = ImGui::GetPlatformIO();
 
@@ -337,13 +327,23 @@ namespace Tempo {
 
             int width, height;
             glfwGetFramebufferSize(main_window, &width, &height);
+            latency_tracker.endStage(LATENCY_STAGE_BEFORE_FRAME);
             renderApplication(main_window, width, height, application);
+            if (ImGui::GetIO().WantTextInput && ImGui::GetIO().ConfigInputTextCursorBlink
+                && !deadlines.isPending(cursor_blink)) {
+                cursor_blink = deadlines.add(now + cursor_blink_interval);
+            }
             if (app_state.redraw) {
                 app_state.redraw = false;
                 glfwPostEmptyEvent();
             }
 
             scheduler.finalizeJobs();
+            // A font atlas built in the background has been swapped in, it must be drawn
+            if (FONTM.atlas_swapped) {
+                FONTM.atlas_swapped = false;
+                glfwPostEmptyEvent();
+            }
 
             if (glfwWindowShouldClose(main_window) && !scheduler.isBusy()) {
                 scheduler.abortAll();
@@ -359,9 +359,15 @@ namespace Tempo {
         app_state.loop_running = false;
         app_state.app_initialized = false;
 
+        event_queue.setWakeupCallback(nullptr);
+        deadlines.setWakeupCallback(nullptr);
+        trace_recorder.reset();
+        latency_tracker.setEnabled(false);
         // event_queue.unsubscribe(&tempo_listener);
         // Shut down ImGui and ImPlot
         ImGui_ImplOpenGL3_DestroyFontsTexture();
+        FONTM.destroyTextures();
+        DamageTracker::getInstance().destroy();
         ImGui_ImplGlfw_Shutdown();
         ImGui_ImplOpenGL3_Shutdown();
         application->AfterLoop();
@@ -0,0 +1,469 @@
+#include "atlas_cache.h"
+#include "fonts_private.h"
+#include "../mapped_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace Tempo {
+    namespace {
+        constexpr char cache_magic[8] = { 'T', 'E', 'M', 'P', 'O', 'A', 'T', 'L' };
+        constexpr uint32_t cache_version = 1;
+
+        template <typename T>
+        void hash_value(uint64_t& hash, T value) {
+            hash = hashBytes(&value, sizeof(T), hash);
+        }
+
+        void hash_string(uint64_t& hash, const std::string& str) {
+            hash_value(hash, (uint64_t)str.size());
+            hash = hashBytes(str.data(), str.size(), hash);
+        }
+
+        // Ranges are pairs of ImWchar, terminated by 0
+        void hash_ranges(uint64_t& hash, const ImWchar* ranges) {
+            for (; ranges != nullptr && ranges[0] != 0; ranges += 2) {
+                hash_value(hash, (uint32_t)ranges[0]);
+                hash_value(hash, (uint32_t)ranges[1]);
+            }
+            hash_value(hash, (uint32_t)0);
+        }
+
+        void hash_font(uint64_t& hash, const FontInfo& font) {
+            hash_string(hash, font.filename);
+            if (font.filename.empty()) {
+                // Font from memory
+                hash_value(hash, font.data == nullptr ? (uint64_t)0 : font.data->hash);
+            }
+            else {
+                FileStamp stamp = getFileStamp(font.filename);
+                hash_value(hash, stamp.size);
+                hash_value(hash, stamp.modification_time);
+            }
+            hash_value(hash, font.size_pixels);
+            hash_value(hash, font.no_dpi);
+            hash_value(hash, font.flags);
+            hash_ranges(hash, font.glyph_ranges.empty() ? nullptr : &font.glyph_ranges[0]);
+
+            // The fields of ImFontConfig are hashed one by one, because of the padding
+            const ImFontConfig& cfg = font.font_cfg;
+            hash_value(hash, cfg.FontNo);
+            hash_value(hash, cfg.OversampleH);
+            hash_value(hash, cfg.OversampleV);
+            hash_value(hash, cfg.PixelSnapH);
+            hash_value(hash, cfg.GlyphExtraSpacing.x);
+            hash_value(hash, cfg.GlyphExtraSpacing.y);
+            hash_value(hash, cfg.GlyphOffset.x);
+            hash_value(hash, cfg.GlyphOffset.y);
+            hash_value(hash, cfg.GlyphMinAdvanceX);
+            hash_value(hash, cfg.GlyphMaxAdvanceX);
+            hash_value(hash, cfg.MergeMode);
+            hash_value(hash, cfg.FontBuilderFlags);
+            hash_value(hash, cfg.RasterizerMultiply);
+            hash_value(hash, (uint32_t)cfg.EllipsisChar);
+            hash_ranges(hash, cfg.GlyphRanges);
+
+            hash_value(hash, (uint64_t)font.icons.size());
+            for (const auto& icon_font : font.icons) {
+                hash_font(hash, icon_font);
+            }
+        }
+
+        std::set<std::string> font_files(const FontAtlasBuild& build) {
+            std::set<std::string> files;
+            for (const auto& font_pair : build.fonts) {
+                files.insert(font_pair.second.filename);
+                for (const auto& icon_font : font_pair.second.icons) {
+                    files.insert(icon_font.filename);
+                }
+            }
+            // Fonts from memory are covered by the key
+            files.erase(std::string());
+            return files;
+        }
+
+        bool hash_file(const std::string& path, uint64_t& hash) {
+            try {
+                MappedFile file(path);
+                hash = hashBytes(file.data(), file.size());
+                return true;
+            }
+            catch (const MappedFileException&) {
+                return false;
+            }
+        }
+
+        template <typename T>
+        void put(std::vector<char>& buffer, T value) {
+            auto unsigned_value = (uint64_t)value;
+            for (size_t i = 0; i < sizeof(T); i++) {
+                buffer.push_back((char)((unsigned_value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        void put_float(std::vector<char>& buffer, float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(float));
+            put(buffer, bits);
+        }
+
+        void put_string(std::vector<char>& buffer, const std::string& str) {
+            put(buffer, (uint16_t)str.size());
+            buffer.insert(buffer.end(), str.begin(), str.end());
+        }
+
+        /*
+         * Reads the mapped cache, throws std::out_of_range if it is truncated
+         */
+        class CacheReader {
+        private:
+            const unsigned char* data_;
+            size_t size_;
+            size_t pos_ = 0;
+
+            void check(size_t length) {
+                if (pos_ + length > size_)
+                    throw std::out_of_range("Atlas cache is truncated");
+            }
+
+        public:
+            CacheReader(const unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+            template <typename T>
+            T get() {
+                check(sizeof(T));
+                uint64_t value = 0;
+                for (size_t i = 0; i < sizeof(T); i++) {
+                    value |= (uint64_t)data_[pos_ + i] << (8 * i);
+                }
+                pos_ += sizeof(T);
+                return (T)value;
+            }
+
+            float getFloat() {
+                uint32_t bits = get<uint32_t>();
+                float value;
+                std::memcpy(&value, &bits, sizeof(float));
+                return value;
+            }
+
+            std::string getString() {
+                size_t length = get<uint16_t>();
+                check(length);
+                std::string str((const char*)data_ + pos_, length);
+                pos_ += length;
+                return str;
+            }
+
+            const unsigned char* getBytes(size_t length) {
+                check(length);
+                const unsigned char* bytes = data_ + pos_;
+                pos_ += length;
+                return bytes;
+            }
+        };
+
+        /*
+         * Reads the header, and the font files with their content hash
+         * @return false if the file is not an atlas cache
+         */
+        bool read_header(CacheReader& reader, uint64_t& key, std::vector<std::pair<std::string, uint64_t>>& files) {
+            const unsigned char* magic = reader.getBytes(sizeof(cache_magic));
+            if (std::memcmp(magic, cache_magic, sizeof(cache_magic)) != 0 || reader.get<uint32_t>() != cache_version)
+                return false;
+            key = reader.get<uint64_t>();
+            uint32_t files_count = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < files_count; i++) {
+                std::string file = reader.getString();
+                files.emplace_back(std::move(file), reader.get<uint64_t>());
+            }
+            return true;
+        }
+    }
+
+    uint64_t computeAtlasCacheKey(const FontAtlasBuild& build) {
+        uint64_t hash = hashBytes(cache_magic, sizeof(cache_magic));
+        // The cache depends on the layout of ImGui's structures and on the rasterizer
+        hash_value(hash, cache_version);
+        hash_value(hash, (uint32_t)IMGUI_VERSION_NUM);
+        hash_value(hash, (uint32_t)sizeof(ImWchar));
+#ifdef ADVANCED_TEXT
+        hash_value(hash, (uint32_t)1);
+#endif
+        hash_value(hash, build.atlas.Flags);
+        hash_value(hash, build.atlas.TexDesiredWidth);
+        hash_value(hash, build.atlas.TexGlyphPadding);
+
+        for (float scale : build.scales) {
+            hash_value(hash, scale);
+        }
+        for (const auto& font_pair : build.fonts) {
+            hash_value(hash, font_pair.first);
+            hash_font(hash, font_pair.second);
+        }
+        return hash;
+    }
+
+    bool serializeAtlasCache(const FontAtlasBuild& build, AtlasCacheData& data) {
+        const ImFontAtlas& atlas = build.atlas;
+        if (!build.built)
+            return false;
+
+        auto font_index = [&atlas](const ImFont* font) {
+            for (int i = 0; i < atlas.Fonts.Size; i++) {
+                if (atlas.Fonts[i] == font)
+                    return i;
+            }
+            return -1;
+        };
+
+        data.key = build.cache_key;
+        auto files = font_files(build);
+        data.files.assign(files.begin(), files.end());
+        std::vector<char>& buffer = data.atlas;
+        buffer.clear();
+
+        // Texture
+        const bool colors = atlas.TexPixelsRGBA32 != nullptr && atlas.TexPixelsUseColors;
+        if (!colors && atlas.TexPixelsAlpha8 == nullptr)
+            return false;
+        put(buffer, (uint32_t)atlas.TexWidth);
+        put(buffer, (uint32_t)atlas.TexHeight);
+        put(buffer, (uint8_t)colors);
+        put_float(buffer, atlas.TexUvScale.x);
+        put_float(buffer, atlas.TexUvScale.y);
+        put_float(buffer, atlas.TexUvWhitePixel.x);
+        put_float(buffer, atlas.TexUvWhitePixel.y);
+        put(buffer, (uint32_t)IM_ARRAYSIZE(atlas.TexUvLines));
+        for (const ImVec4& uv : atlas.TexUvLines) {
+            put_float(buffer, uv.x);
+            put_float(buffer, uv.y);
+            put_float(buffer, uv.z);
+            put_float(buffer, uv.w);
+        }
+        put(buffer, (int32_t)atlas.PackIdMouseCursors);
+        put(buffer, (int32_t)atlas.PackIdLines);
+
+        // Fonts
+        put(buffer, (uint32_t)atlas.Fonts.Size);
+        for (const ImFont* font : atlas.Fonts) {
+            put_float(buffer, font->FontSize);
+            put_float(buffer, font->Ascent);
+            put_float(buffer, font->Descent);
+            put(buffer, (uint32_t)font->FallbackChar);
+            put(buffer, (uint32_t)font->EllipsisChar);
+            put(buffer, (uint32_t)font->Glyphs.Size);
+            for (const ImFontGlyph& glyph : font->Glyphs) {
+                put(buffer, (uint32_t)glyph.Codepoint);
+                put(buffer, (uint8_t)glyph.Colored);
+                for (float value : { glyph.AdvanceX, glyph.X0, glyph.Y0, glyph.X1, glyph.Y1, glyph.U0, glyph.V0, glyph.U1, glyph.V1 })
+                    put_float(buffer, value);
+            }
+        }
+
+        // Custom rectangles (mouse cursors, lines, custom glyphs)
+        put(buffer, (uint32_t)atlas.CustomRects.Size);
+        for (const ImFontAtlasCustomRect& rect : atlas.CustomRects) {
+            put(buffer, rect.Width);
+            put(buffer, rect.Height);
+            put(buffer, rect.X);
+            put(buffer, rect.Y);
+            put(buffer, (uint32_t)rect.GlyphID);
+            put_float(buffer, rect.GlyphAdvanceX);
+            put_float(buffer, rect.GlyphOffset.x);
+            put_float(buffer, rect.GlyphOffset.y);
+            put(buffer, (int32_t)font_index(rect.Font));
+        }
+
+        // ImFont of each font and scale
+        uint32_t handles_count = 0;
+        for (const auto& font_pair : build.fonts)
+            handles_count += (uint32_t)font_pair.second.multi_scale_font.size();
+        put(buffer, handles_count);
+        for (const auto& font_pair : build.fonts) {
+            for (const auto& pair : font_pair.second.multi_scale_font) {
+                int index = font_index(pair.second->im_font);
+                if (index < 0)
+                    return false;
+                put(buffer, font_pair.first);
+                put_float(buffer, pair.first);
+                put(buffer, (int32_t)index);
+            }
+        }
+
+        const size_t pixels_size = (size_t)atlas.TexWidth * (size_t)atlas.TexHeight * (colors ? 4 : 1);
+        const char* pixels = colors ? (const char*)atlas.TexPixelsRGBA32 : (const char*)atlas.TexPixelsAlpha8;
+        buffer.insert(buffer.end(), pixels, pixels + pixels_size);
+        return true;
+    }
+
+    bool writeAtlasCache(const AtlasCacheData& data, const std::string& path) {
+        std::vector<char> header;
+        header.insert(header.end(), cache_magic, cache_magic + sizeof(cache_magic));
+        put(header, cache_version);
+        put(header, data.key);
+
+        put(header, (uint32_t)data.files.size());
+        for (const auto& file : data.files) {
+            uint64_t hash;
+            if (!hash_file(file, hash))
+                return false;
+            put_string(header, file);
+            put(header, hash);
+        }
+
+        // Each atlas has its own temporary file, several writes can be in progress
+        char key[17];
+        std::snprintf(key, sizeof(key), "%016llx", (unsigned long long)data.key);
+        std::string tmp_path = path + "." + key + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+            file.write(header.data(), (std::streamsize)header.size());
+            file.write(data.atlas.data(), (std::streamsize)data.atlas.size());
+            if (!file.good())
+                return false;
+        }
+        std::remove(path.c_str());
+        return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+    }
+
+    bool loadAtlasCache(FontAtlasBuild& build, const std::string& path) {
+        ImFontAtlas& atlas = build.atlas;
+        try {
+            MappedFile file(path);
+            CacheReader reader(file.data(), file.size());
+
+            uint64_t key;
+            std::vector<std::pair<std::string, uint64_t>> files;
+            if (!read_header(reader, key, files) || key != build.cache_key)
+                return false;
+
+            atlas.Clear();
+            const int width = (int)reader.get<uint32_t>();
+            const int height = (int)reader.get<uint32_t>();
+            const bool colors = reader.get<uint8_t>() != 0;
+            atlas.TexWidth = width;
+            atlas.TexHeight = height;
+            atlas.TexUvScale.x = reader.getFloat();
+            atlas.TexUvScale.y = reader.getFloat();
+            atlas.TexUvWhitePixel.x = reader.getFloat();
+            atlas.TexUvWhitePixel.y = reader.getFloat();
+            if (reader.get<uint32_t>() != (uint32_t)IM_ARRAYSIZE(atlas.TexUvLines))
+                throw std::out_of_range("Atlas cache has another line texture");
+            for (ImVec4& uv : atlas.TexUvLines) {
+                uv.x = reader.getFloat();
+                uv.y = reader.getFloat();
+                uv.z = reader.getFloat();
+                uv.w = reader.getFloat();
+            }
+            atlas.PackIdMouseCursors = reader.get<int32_t>();
+            atlas.PackIdLines = reader.get<int32_t>();
+
+            const uint32_t fonts_count = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < fonts_count; i++) {
+                ImFont* font = IM_NEW(ImFont);
+                atlas.Fonts.push_back(font);
+                font->ContainerAtlas = &atlas;
+                font->FontSize = reader.getFloat();
+                font->Ascent = reader.getFloat();
+                font->Descent = reader.getFloat();
+                font->FallbackChar = (ImWchar)reader.get<uint32_t>();
+                font->EllipsisChar = (ImWchar)reader.get<uint32_t>();
+                const uint32_t glyphs_count = reader.get<uint32_t>();
+                font->Glyphs.reserve((int)glyphs_count);
+                for (uint32_t g = 0; g < glyphs_count; g++) {
+                    const ImWchar codepoint = (ImWchar)reader.get<uint32_t>();
+                    const bool colored = reader.get<uint8_t>() != 0;
+                    float values[9];
+                    for (float& value : values)
+                        value = reader.getFloat();
+                    font->AddGlyph(nullptr, codepoint, values[1], values[2], values[3], values[4],
+                        values[5], values[6], values[7], values[8], values[0]);
+                    font->Glyphs.back().Colored = colored;
+                }
+                font->BuildLookupTable();
+            }
+
+            const uint32_t rects_count = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < rects_count; i++) {
+                ImFontAtlasCustomRect rect;
+                rect.Width = reader.get<unsigned short>();
+                rect.Height = reader.get<unsigned short>();
+                rect.X = reader.get<unsigned short>();
+                rect.Y = reader.get<unsigned short>();
+                rect.GlyphID = reader.get<uint32_t>();
+                rect.GlyphAdvanceX = reader.getFloat();
+                rect.GlyphOffset.x = reader.getFloat();
+                rect.GlyphOffset.y = reader.getFloat();
+                int32_t index = reader.get<int32_t>();
+                rect.Font = (index >= 0 && index < atlas.Fonts.Size) ? atlas.Fonts[index] : nullptr;
+                atlas.CustomRects.push_back(rect);
+            }
+
+            const uint32_t handles_count = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < handles_count; i++) {
+                const auto font_id = reader.get<uint32_t>();
+                const float scale = reader.getFloat();
+                const int32_t index = reader.get<int32_t>();
+                auto font_it = build.fonts.find(font_id);
+                if (font_it == build.fonts.end() || index < 0 || index >= atlas.Fonts.Size)
+                    throw std::out_of_range("Atlas cache does not match the fonts");
+                font_it->second.multi_scale_font[scale] = std::make_shared<SafeImFont>(SafeImFont{ atlas.Fonts[index] });
+            }
+
+            // Pixels are copied from the mapping once, ImGui owns (and frees) them
+            const size_t pixels_size = (size_t)width * (size_t)height * (colors ? 4 : 1);
+            const unsigned char* pixels = reader.getBytes(pixels_size);
+            if (colors) {
+                atlas.TexPixelsRGBA32 = (unsigned int*)IM_ALLOC(pixels_size);
+                atlas.TexPixelsUseColors = true;
+                std::memcpy(atlas.TexPixelsRGBA32, pixels, pixels_size);
+            }
+            else {
+                atlas.TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(pixels_size);
+                std::memcpy(atlas.TexPixelsAlpha8, pixels, pixels_size);
+            }
+            atlas.TexReady = true;
+        }
+        catch (const MappedFileException&) {
+            return false;
+        }
+        catch (const std::out_of_range&) {
+            atlas.Clear();
+            for (auto& font_pair : build.fonts)
+                font_pair.second.multi_scale_font.clear();
+            return false;
+        }
+        build.built = true;
+        return true;
+    }
+
+    bool validateAtlasCache(const std::string& path) {
+        try {
+            MappedFile file(path);
+            CacheReader reader(file.data(), file.size());
+            uint64_t key;
+            std::vector<std::pair<std::string, uint64_t>> files;
+            if (!read_header(reader, key, files))
+                return false;
+            for (const auto& pair : files) {
+                uint64_t hash;
+                if (!hash_file(pair.first, hash) || hash != pair.second)
+                    return false;
+            }
+            return true;
+        }
+        catch (const MappedFileException&) {
+            return false;
+        }
+        catch (const std::out_of_range&) {
+            return false;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tempo {
+    struct FontAtlasBuild;
+
+    /**
+     * @brief Computes the key of an atlas in the on-disk cache
+     *
+     * The key covers everything the atlas is built from: the font files
+     * (path, size and modification time) or the content of the fonts from memory, the pixel sizes, the glyph ranges,
+     * the ImFontConfig of each font and icon set, and the scales.
+     * It does not read the font files, their content is checked by validateAtlasCache.
+     */
+    uint64_t computeAtlasCacheKey(const FontAtlasBuild& build);
+
+    /**
+     * Content of the cache file of an atlas, without the hashes of the font files
+     */
+    struct AtlasCacheData {
+        uint64_t key = 0;
+        std::vector<std::string> files;
+        // Texture, glyphs and metrics
+        std::vector<char> atlas;
+    };
+
+    /**
+     * @brief Copies a built atlas (pixels, glyphs and metrics) in memory, without reading any file
+     * Atlases in which a font could not be loaded are not saved.
+     *
+     * @return false if the atlas cannot be cached
+     */
+    bool serializeAtlasCache(const FontAtlasBuild& build, AtlasCacheData& data);
+
+    /**
+     * @brief Writes a serialized atlas to the cache file
+     * Reads every font file to hash it, should be called from a worker.
+     *
+     * The file is written next to the destination then renamed, so that a
+     * running instance which mapped the previous cache is not disturbed.
+     *
+     * @return true if the cache has been written
+     */
+    bool writeAtlasCache(const AtlasCacheData& data, const std::string& path);
+
+    /**
+     * @brief Fills the atlas of the build from the cache file, without rasterizing the fonts
+     *
+     * The file is memory-mapped and the pixels are copied once into the atlas,
+     * ready to be uploaded. The ImFonts are recreated glyph by glyph, and
+     * build.fonts receives their ImFont*.
+     *
+     * @return false if the file does not exist, is corrupted, or has another key
+     */
+    bool loadAtlasCache(FontAtlasBuild& build, const std::string& path);
+
+    /**
+     * @brief Checks that the font files used by the cached atlas still have the same content
+     * Reads every font file, should be called from a worker
+     *
+     * @return false if a file changed (or the cache cannot be read)
+     */
+    bool validateAtlasCache(const std::string& path);
+}
\ No newline at end of file
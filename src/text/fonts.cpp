@@ -1,40 +1,614 @@
 #include "fonts.h"
 #include "fonts_private.h"
+#include "atlas_cache.h"
+#include "sdf_font.h"
+#include "../jobscheduler.h"
+#include "imgui_impl_opengl3.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
 
 namespace Tempo {
-    std::optional<FontID> AddFontFromFileTTF(const std::string& filename, float size_pixels, ImFontConfig font_cfg, ImVector<ImWchar> glyph_ranges, bool no_dpi) {
+    namespace {
+        /*
+         * Adds the font to the atlas from its shared data, so that the file is not read again
+         */
+        ImFont* add_font(ImFontAtlas& atlas, const FontInfo& font, float size, ImFontConfig cfg, const ImWchar* glyph_ranges) {
+            if (font.data == nullptr)
+                return nullptr;
+            cfg.FontDataOwnedByAtlas = false;
+            // Same name as ImFontAtlas::AddFontFromFileTTF, shown in the debug tools
+            if (cfg.Name[0] == '\0' && !font.filename.empty()) {
+                const size_t separator = font.filename.find_last_of("/\\");
+                const std::string name = separator == std::string::npos ? font.filename : font.filename.substr(separator + 1);
+                snprintf(cfg.Name, sizeof(cfg.Name), "%s, %.0fpx", name.c_str(), size);
+            }
+            // The data is only read, ImGui never writes in fonts it does not own
+            return atlas.AddFontFromMemoryTTF((void*)font.data->data, (int)font.data->size, size, &cfg, glyph_ranges);
+        }
+
+        /*
+         * Adds the font with only the space glyph, the other glyphs (and the icons)
+         * are added as distance fields by the SDF builder
+         */
+        void add_sdf_font(ImFontAtlas& atlas, SdfFontBuilder& builder, FontInfo& font) {
+            static const ImWchar space_range[] = { 0x0020, 0x0020, 0 };
+            // Offsets and spacing are given in pixels at the size of the font
+            const float ratio = SdfFontBuilder::font_size / font.size_pixels;
+            auto scaled_cfg = [ratio](ImFontConfig cfg) {
+                cfg.GlyphOffset = ImVec2(ratio * cfg.GlyphOffset.x, ratio * cfg.GlyphOffset.y);
+                cfg.GlyphExtraSpacing = ImVec2(ratio * cfg.GlyphExtraSpacing.x, ratio * cfg.GlyphExtraSpacing.y);
+                return cfg;
+            };
+            auto ranges = [&atlas](const FontInfo& info) {
+                if (!info.glyph_ranges.empty())
+                    return &info.glyph_ranges[0];
+                return info.font_cfg.GlyphRanges != nullptr ? info.font_cfg.GlyphRanges : atlas.GetGlyphRangesDefault();
+            };
+
+            ImFontConfig cfg = scaled_cfg(font.font_cfg);
+            ImFont* imfont = add_font(atlas, font, SdfFontBuilder::font_size, cfg, space_range);
+            if (imfont != nullptr) {
+                builder.addGlyphs(atlas, imfont, *font.data, cfg, ranges(font));
+                for (auto& icon_font : font.icons) {
+                    if (icon_font.data != nullptr)
+                        builder.addGlyphs(atlas, imfont, *icon_font.data, scaled_cfg(icon_font.font_cfg), ranges(icon_font));
+                }
+            }
+            // One font for all the scales
+            font.multi_scale_font[1.f] = std::make_shared<SafeImFont>(SafeImFont{ imfont });
+        }
+
+        void destroy_textures(FontAtlasBuild& build) {
+            ImGui_ImplOpenGL3_DestroyFontAtlasTexture(&build.atlas);
+            ImGui_ImplOpenGL3_DestroyFontAtlasTexture(&build.sdf_atlas);
+        }
+
+        std::optional<FontID> register_font(FontInfo& font) {
+            FONTM.font_counter++;
+
+            FontID font_id = (FontID)FONTM.font_counter;
+            FONTM.font_atlas.insert(std::make_pair(font_id, font));
+            FONTM.pending_fonts.insert((uint32_t)font_id);
+            FONTM.updateFontTable();
+
+            return std::optional<FontID>(font_id);
+        }
+
+        std::shared_ptr<FontData> data_from_memory(void* font_data, int font_size, bool owned) {
+            auto data = std::make_shared<FontData>();
+            data->data = (const unsigned char*)font_data;
+            data->size = (size_t)font_size;
+            data->hash = hashBytes(data->data, data->size);
+            if (owned)
+                data->owned_data = font_data;
+            return data;
+        }
+    }
+
+    FontData::~FontData() {
+        if (owned_data != nullptr)
+            IM_FREE(owned_data);
+    }
+
+    FontDataPtr FontManager::mapFontFile(const std::string& filename) {
+        auto it = mapped_files.find(filename);
+        if (it != mapped_files.end()) {
+            if (auto data = it->second.lock())
+                return data;
+        }
+        auto data = std::make_shared<FontData>();
+        try {
+            data->file = std::make_unique<MappedFile>(filename);
+        }
+        catch (const MappedFileException&) {
+            return nullptr;
+        }
+        data->data = data->file->data();
+        data->size = data->file->size();
+        mapped_files[filename] = data;
+        return data;
+    }
+
+    void FontManager::addScale(float scale) {
+        if (scale <= 0.f)
+            return;
+        // Content scales are rounded, to avoid building fonts for rounding errors
+        scale = std::round(scale * 100.f) / 100.f;
+        if (scales.insert(scale).second)
+            reconstruct_fonts = true;
+    }
+
+    float FontManager::findScale(const FontInfo& font, float dpi_scale) {
+        if (font.multi_scale_font.empty())
+            return 0.f;
+        auto it = font.multi_scale_font.lower_bound(dpi_scale);
+        if (it == font.multi_scale_font.end())
+            return std::prev(it)->first;
+        if (it == font.multi_scale_font.begin())
+            return it->first;
+        auto prev = std::prev(it);
+        return (dpi_scale - prev->first < it->first - dpi_scale) ? prev->first : it->first;
+    }
+
+    void FontManager::updateFontTable() {
+        font_table.clear();
+        font_table.resize((size_t)font_counter + 1);
+        for (const auto& font_pair : font_atlas) {
+            FontSlot& slot = font_table[font_pair.first];
+            const FontInfo& font = font_pair.second;
+            slot.size_pixels = font.size_pixels;
+            slot.no_dpi = font.no_dpi;
+            slot.sdf = font.flags & FONT_FLAGS_SDF;
+            for (const auto& pair : font.multi_scale_font) {
+                if (pair.second != nullptr && pair.second->im_font != nullptr)
+                    slot.fonts.emplace_back(pair.first, pair.second->im_font);
+            }
+        }
+    }
+
+    void FontManager::update() {
+        // Pages whose fonts have all been removed or rebuilt elsewhere
+        for (auto it = pages.begin(); it != pages.end();) {
+            if ((*it)->live_fonts.empty()) {
+                destroy_textures(**it);
+                it = pages.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+
+        if (building)
+            return;
+        if (!front_build->built || reconstruct_fonts) {
+            buildAtlas();
+            return;
+        }
+        if (pending_fonts.empty())
+            return;
+
+        bool compact = pages.size() >= max_pages;
+        for (uint32_t font_id : pending_fonts) {
+            // A font merged in the previous font cannot be the first font of a page
+            auto it = font_atlas.find(font_id);
+            if (it != font_atlas.end() && it->second.font_cfg.MergeMode)
+                compact = true;
+        }
+        if (compact)
+            buildAtlas();
+        else
+            buildPage();
+    }
+
+    void FontManager::prepare_build(FontAtlasBuild& build, bool all_fonts) {
+        // The main window scale is built first, so that the default ImGui font
+        // is the first font at this scale
+        build.scales = { std::round(main_scale * 100.f) / 100.f };
+        for (float scale : scales) {
+            if (scale != build.scales[0])
+                build.scales.push_back(scale);
+        }
+
+        build.fonts.clear();
+        build.live_fonts.clear();
+        build.built = false;
+        build.cache_path.clear();
+        build.from_cache = false;
+        if (all_fonts) {
+            build.fonts = font_atlas;
+        }
+        else {
+            for (uint32_t font_id : pending_fonts) {
+                auto it = font_atlas.find(font_id);
+                if (it != font_atlas.end())
+                    build.fonts.insert(*it);
+            }
+        }
+        // Fonts added or changed during the build are built afterwards
+        pending_fonts.clear();
+
+        // Dynamic fonts are only built with the glyphs that have been used
+        glyph_cache.update(font_atlas, build.scales);
+        if (glyph_cache.isEnabled() && all_fonts)
+            glyph_cache.evict();
+        for (auto& font_pair : build.fonts) {
+            FontInfo& font = font_pair.second;
+            font.multi_scale_font.clear();
+            if ((font.flags & FONT_FLAGS_DYNAMIC_GLYPHS) && !font.glyph_ranges.empty())
+                font.glyph_ranges = glyph_cache.getRanges(font);
+        }
+    }
+
+    void FontManager::run_build(std::shared_ptr<FontAtlasBuild> build_ptr, std::function<void(std::shared_ptr<FontAtlasBuild>)> on_built) {
+        if (!build_in_background) {
+            build(*build_ptr);
+            on_built(build_ptr);
+            return;
+        }
+
+        building = true;
+        jobFct job = [build_ptr](float&, bool& abort) {
+            auto result = std::make_shared<JobResult>();
+            if (!abort) {
+                build(*build_ptr);
+                result->success = true;
+            }
+            return result;
+        };
+        jobResultFct result_fct = [build_ptr, on_built](const std::shared_ptr<JobResult>& result) {
+            FONTM.building = false;
+            if (result->success)
+                on_built(build_ptr);
+        };
+        JobScheduler::getInstance().addJob("Tempo/font_atlas", job, result_fct, Job::JOB_PRIORITY_HIGH);
+    }
+
+    void FontManager::buildAtlas() {
+        if (building)
+            return;
+        reconstruct_fonts = false;
+        addScale(main_scale);
+
+        FontAtlasBuild& next = *back_build;
+        prepare_build(next, true);
+        // The cache only holds the bitmap atlas of fixed glyph ranges: the glyphs of
+        // dynamic fonts change with each glyph miss, the cache would never be hit
+        bool cacheable = true;
+        for (const auto& font_pair : next.fonts) {
+            if (font_pair.second.flags & (FONT_FLAGS_SDF | FONT_FLAGS_DYNAMIC_GLYPHS))
+                cacheable = false;
+        }
+        if (cacheable)
+            next.cache_path = cache_path;
+        if (!next.cache_path.empty())
+            next.cache_key = computeAtlasCacheKey(next);
+
+        if (!front_build->built) {
+            if (!next.cache_path.empty() && loadAtlasCache(next, cache_path)) {
+                next.from_cache = true;
+                swapAtlas();
+                validate_cache();
+            }
+            else {
+                build(next);
+                swapAtlas();
+            }
+            return;
+        }
+        run_build(back_build, [](std::shared_ptr<FontAtlasBuild>) {
+            FONTM.swapAtlas();
+            });
+    }
+
+    void FontManager::buildPage() {
+        if (building || pending_fonts.empty())
+            return;
+        auto page = std::make_shared<FontAtlasBuild>();
+        prepare_build(*page, false);
+        if (page->fonts.empty())
+            return;
+        run_build(page, [](std::shared_ptr<FontAtlasBuild> built_page) {
+            FONTM.addPage(std::move(built_page));
+            });
+    }
+
+    void FontManager::build(FontAtlasBuild& build) {
+        const auto start = std::chrono::steady_clock::now();
+        ImFontAtlas& atlas = build.atlas;
+        atlas.Clear();
+        build.sdf_atlas.Clear();
+        // Baked lines would be thresholded by the SDF shader
+        build.sdf_atlas.Flags |= ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoMouseCursors;
+        SdfFontBuilder sdf_builder;
+
+        // For each font, we need one ImFont per scale
+        for (auto& font_pair : build.fonts) {
+            FontInfo& font = font_pair.second;
+            if (font.flags & FONT_FLAGS_SDF) {
+                add_sdf_font(build.sdf_atlas, sdf_builder, font);
+                continue;
+            }
+
+            for (float xscale : build.scales) {
+                if (font.no_dpi) {
+                    xscale = 1.f;
+                    if (!font.multi_scale_font.empty())
+                        break;
+                }
+
+                float size = xscale * font.size_pixels;
+                ImFont* imfont = add_font(atlas, font, size, font.font_cfg,
+                    font.glyph_ranges.empty() ? nullptr : &font.glyph_ranges[0]);
+
+                font.multi_scale_font[xscale] = std::make_shared<SafeImFont>(SafeImFont{ imfont });
+
+                for (auto& icon_font : font.icons) {
+                    ImFontConfig cfg = icon_font.font_cfg;
+                    cfg.GlyphOffset = ImVec2(xscale * cfg.GlyphOffset.x, xscale * cfg.GlyphOffset.y);
+                    cfg.GlyphExtraSpacing = ImVec2(xscale * cfg.GlyphExtraSpacing.x, xscale * cfg.GlyphExtraSpacing.y);
+                    cfg.GlyphMaxAdvanceX = xscale * cfg.GlyphMaxAdvanceX;
+                    cfg.GlyphMinAdvanceX = xscale * cfg.GlyphMinAdvanceX;
+                    add_font(atlas, icon_font, size, cfg,
+                        icon_font.glyph_ranges.empty() ? nullptr : &icon_font.glyph_ranges[0]);
+                }
+            }
+        }
+        // A page with only SDF fonts has no bitmap atlas (io.Fonts gets the default font when uploaded)
+        if (!atlas.ConfigData.empty() || build.sdf_atlas.ConfigData.empty())
+            atlas.Build();
+        if (!build.sdf_atlas.ConfigData.empty()) {
+            build.sdf_atlas.Build();
+            sdf_builder.finish(build.sdf_atlas);
+        }
+        build.built = true;
+        build.build_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // Only copied here, the font files are hashed by the job that writes the cache
+        build.cache_data.reset();
+        if (!build.cache_path.empty()) {
+            auto data = std::make_shared<AtlasCacheData>();
+            if (serializeAtlasCache(build, *data))
+                build.cache_data = std::move(data);
+        }
+    }
+
+    void FontManager::save_cache(FontAtlasBuild& build) {
+        if (!build.cache_data)
+            return;
+        std::shared_ptr<AtlasCacheData> data = std::move(build.cache_data);
+        std::string path = build.cache_path;
+        jobFct job = [data, path](float&, bool& abort) {
+            auto result = std::make_shared<JobResult>();
+            result->success = !abort && writeAtlasCache(*data, path);
+            return result;
+        };
+        jobResultFct result_fct = [](const std::shared_ptr<JobResult>&) {};
+        JobScheduler::getInstance().addJob("Tempo/font_atlas_cache_write", job, result_fct, Job::JOB_PRIORITY_LOW);
+    }
+
+    void FontManager::validate_cache() {
+        std::string path = cache_path;
+        jobFct job = [path](float&, bool& abort) {
+            auto result = std::make_shared<JobResult>();
+            result->success = abort || validateAtlasCache(path);
+            return result;
+        };
+        jobResultFct result_fct = [path](const std::shared_ptr<JobResult>& result) {
+            if (result->success)
+                return;
+            // A font file changed without changing its size or modification time
+            std::remove(path.c_str());
+            FONTM.reconstruct_fonts = true;
+        };
+        JobScheduler::getInstance().addJob("Tempo/font_atlas_cache", job, result_fct, Job::JOB_PRIORITY_LOW);
+    }
+
+    void FontManager::bind_fonts(FontAtlasBuild& build) {
+        // Handles given to the user stay the same, only the ImFont* changes
+        for (auto& font_pair : build.fonts) {
+            auto font_it = font_atlas.find(font_pair.first);
+            // Removed while the atlas was being built
+            if (font_it == font_atlas.end())
+                continue;
+            FontInfo& font = font_it->second;
+            for (auto it = font.multi_scale_font.begin(); it != font.multi_scale_font.end();) {
+                if (!font_pair.second.multi_scale_font.count(it->first)) {
+                    it->second->im_font = nullptr;
+                    it = font.multi_scale_font.erase(it);
+                }
+                else {
+                    it++;
+                }
+            }
+            for (auto& pair : font_pair.second.multi_scale_font) {
+                auto& handle = font.multi_scale_font[pair.first];
+                if (handle == nullptr)
+                    handle = std::make_shared<SafeImFont>(SafeImFont{ nullptr });
+                handle->im_font = pair.second->im_font;
+            }
+            build.live_fonts.insert(font_pair.first);
+
+            // The previous glyphs of the font are now unused space
+            if (front_build.get() != &build)
+                front_build->live_fonts.erase(font_pair.first);
+            for (auto& page : pages) {
+                if (page.get() != &build)
+                    page->live_fonts.erase(font_pair.first);
+            }
+        }
+    }
+
+    void FontManager::swapAtlas() {
+        std::swap(front_build, back_build);
+        ImGui::GetIO().Fonts = &front_build->atlas;
+        bind_fonts(*front_build);
+
+        // Fonts added while the atlas was being built are not in it yet
+        for (auto& font_pair : font_atlas) {
+            if (front_build->fonts.count(font_pair.first))
+                continue;
+            for (auto& pair : font_pair.second.multi_scale_font) {
+                pair.second->im_font = nullptr;
+            }
+            font_pair.second.multi_scale_font.clear();
+        }
+
+        ImGui_ImplOpenGL3_DestroyFontsTexture();
+        ImGui_ImplOpenGL3_CreateFontsTexture();
+        ImGui_ImplOpenGL3_DestroyFontAtlasTexture(&back_build->sdf_atlas);
+        if (!front_build->sdf_atlas.Fonts.empty())
+            ImGui_ImplOpenGL3_CreateFontAtlasTexture(&front_build->sdf_atlas, true);
+        atlas_generation++;
+        stats.last_build_ms = front_build->build_ms;
+        stats.last_build_bytes = textureBytes(*front_build);
+        stats.builds++;
+        save_cache(*front_build);
+        // The previous atlas is only kept for its memory, until the next build
+        back_build->atlas.Clear();
+        back_build->sdf_atlas.Clear();
+        back_build->live_fonts.clear();
+        // The pages have been merged in the atlas
+        destroyPages();
+        updateFontTable();
+        atlas_swapped = true;
+    }
+
+    void FontManager::addPage(std::shared_ptr<FontAtlasBuild> page) {
+        if (page->atlas.IsBuilt())
+            ImGui_ImplOpenGL3_CreateFontAtlasTexture(&page->atlas);
+        if (!page->sdf_atlas.Fonts.empty())
+            ImGui_ImplOpenGL3_CreateFontAtlasTexture(&page->sdf_atlas, true);
+        atlas_generation++;
+        stats.last_build_ms = page->build_ms;
+        stats.last_build_bytes = textureBytes(*page);
+        stats.builds++;
+        pages.push_back(page);
+        bind_fonts(*page);
+        updateFontTable();
+        atlas_swapped = true;
+        // The glyphs of the fonts rebuilt on the page are dead in the previous atlases
+        if (getFragmentation() > compaction_threshold)
+            reconstruct_fonts = true;
+    }
+
+    void FontManager::glyphsMissing() {
+        if (glyph_cache.isOverBudget()) {
+            reconstruct_fonts = true;
+            return;
+        }
+        for (const auto& pair : font_atlas) {
+            if ((pair.second.flags & FONT_FLAGS_DYNAMIC_GLYPHS) && !pair.second.glyph_ranges.empty())
+                pending_fonts.insert(pair.first);
+        }
+    }
+
+    void FontManager::removeFont(uint32_t font_id) {
+        front_build->live_fonts.erase(font_id);
+        for (auto& page : pages) {
+            page->live_fonts.erase(font_id);
+        }
+        pending_fonts.erase(font_id);
+        if (getFragmentation() > compaction_threshold)
+            reconstruct_fonts = true;
+    }
+
+    float FontManager::getFragmentation() const {
+        size_t total = 0;
+        size_t live = 0;
+        auto count = [&total, &live](const FontAtlasBuild& build) {
+            std::set<const ImFont*> live_fonts;
+            for (uint32_t font_id : build.live_fonts) {
+                auto it = build.fonts.find(font_id);
+                if (it == build.fonts.end())
+                    continue;
+                for (const auto& pair : it->second.multi_scale_font) {
+                    live_fonts.insert(pair.second->im_font);
+                }
+            }
+            for (const ImFontAtlas* atlas : { &build.atlas, &build.sdf_atlas }) {
+                for (const ImFont* font : atlas->Fonts) {
+                    total += (size_t)font->MetricsTotalSurface;
+                    if (live_fonts.count(font))
+                        live += (size_t)font->MetricsTotalSurface;
+                }
+            }
+        };
+        count(*front_build);
+        for (const auto& page : pages) {
+            count(*page);
+        }
+        return total == 0 ? 0.f : 1.f - (float)live / (float)total;
+    }
+
+    void FontManager::destroyPages() {
+        for (auto& page : pages) {
+            destroy_textures(*page);
+        }
+        pages.clear();
+    }
+
+    void FontManager::destroyTextures() {
+        destroyPages();
+        ImGui_ImplOpenGL3_DestroyFontAtlasTexture(&front_build->sdf_atlas);
+    }
+
+    size_t FontManager::textureBytes(FontAtlasBuild& build, bool as_rgba) {
+        size_t bytes = 0;
+        for (ImFontAtlas* atlas : { &build.atlas, &build.sdf_atlas }) {
+            if (atlas->TexID == 0)
+                continue;
+            if (as_rgba)
+                bytes += (size_t)atlas->TexWidth * (size_t)atlas->TexHeight * 4;
+            else
+                bytes += ImGui_ImplOpenGL3_GetFontAtlasTextureBytes(atlas);
+        }
+        return bytes;
+    }
+
+    std::optional<FontID> AddFontFromFileTTF(const std::string& filename, float size_pixels, ImFontConfig font_cfg, ImVector<ImWchar> glyph_ranges, bool no_dpi, int flags) {
         // assert(app_state.app_initialized && "AddFontFromFileTTF cannot be called when the application has not been initialized yet.");
 
         // Assert also for when called in between loop
 
         FontInfo font;
         font.filename = filename;
+        font.data = FONTM.mapFontFile(filename);
+        if (font.data == nullptr)
+            return std::optional<FontID>();
         font.size_pixels = size_pixels;
         font.font_cfg = font_cfg;
         font.glyph_ranges = glyph_ranges;
         font.no_dpi = no_dpi;
+        font.flags = flags;
 
+        return register_font(font);
+    }
 
-        // TODO: check if file exists and can be loaded
-        // auto& io = ImGui::GetIO();
-        // if (glyph_ranges)
+    std::optional<FontID> AddFontFromMemoryTTF(void* font_data, int font_size, float size_pixels, ImFontConfig font_cfg, ImVector<ImWchar> glyph_ranges, bool no_dpi, int flags) {
+        if (font_data == nullptr || font_size <= 0)
+            return std::optional<FontID>();
 
-        // ImFont* imfont = nullptr;
-        // if (font.glyph_ranges.empty())
-        //     imfont = io.Fonts->AddFontFromFileTTF(font.filename.c_str(), size_pixels, &font.font_cfg);
-        // else
-        //     imfont = io.Fonts->AddFontFromFileTTF(font.filename.c_str(), size_pixels, &font.font_cfg, &font.glyph_ranges[0]);
-        // if (imfont == nullptr) {
-        //     return std::optional<FontID>();
-        // }
-        // font.multi_scale_font[1.f] = FONTM.font_atlas.begin()->second.multi_scale_font.begin()->second;
-        FONTM.font_counter++;
-        FONTM.reconstruct_fonts = true;
+        FontInfo font;
+        font.data = data_from_memory(font_data, font_size, font_cfg.FontDataOwnedByAtlas);
+        font.size_pixels = size_pixels;
+        font.font_cfg = font_cfg;
+        font.glyph_ranges = glyph_ranges;
+        font.no_dpi = no_dpi;
+        font.flags = flags;
+
+        return register_font(font);
+    }
 
-        FontID font_id = (FontID)FONTM.font_counter;
-        FONTM.font_atlas.insert(std::make_pair(font_id, font));
+    std::optional<FontID> AddFontFromCompressedMemoryTTF(const void* compressed_font_data, int compressed_font_size, float size_pixels, ImFontConfig font_cfg, ImVector<ImWchar> glyph_ranges, bool no_dpi, int flags) {
+        if (compressed_font_data == nullptr || compressed_font_size <= 0)
+            return std::optional<FontID>();
 
-        return std::optional<FontID>(font_id);
+        // ImGui decompresses the font when it is added to an atlas (without building it),
+        // the decompressed data is taken from the atlas so that it is only done once
+        void* font_data;
+        int font_size;
+        {
+            ImFontAtlas decompress_atlas;
+            ImFontConfig cfg;
+            if (decompress_atlas.AddFontFromMemoryCompressedTTF(compressed_font_data, compressed_font_size, size_pixels, &cfg) == nullptr)
+                return std::optional<FontID>();
+            ImFontConfig& added_cfg = decompress_atlas.ConfigData.back();
+            font_data = added_cfg.FontData;
+            font_size = added_cfg.FontDataSize;
+            added_cfg.FontDataOwnedByAtlas = false;
+        }
+
+        FontInfo font;
+        font.data = data_from_memory(font_data, font_size, true);
+        font.size_pixels = size_pixels;
+        font.font_cfg = font_cfg;
+        font.glyph_ranges = glyph_ranges;
+        font.no_dpi = no_dpi;
+        font.flags = flags;
+
+        return register_font(font);
     }
 
     bool AddIconsToFont(FontID font_id, const std::string& filename, ImFontConfig font_cfg, ImVector<ImWchar> glyph_ranges) {
@@ -47,14 +621,18 @@ namespace Tempo {
         }
         FontInfo icon_font;
         icon_font.filename = filename;
+        icon_font.data = FONTM.mapFontFile(filename);
+        if (icon_font.data == nullptr)
+            return false;
         icon_font.font_cfg = font_cfg;
         icon_font.glyph_ranges = glyph_ranges;
 
         FontInfo& font_info = FONTM.font_atlas[font_id];
         // auto& io = ImGui::GetIO();
 
-        FONTM.reconstruct_fonts = true;
         font_info.icons.push_back(icon_font);
+        // The font is built again with its icons, in a new page
+        FONTM.pending_fonts.insert((uint32_t)font_id);
 
         // PushFont(font_id);
         // io.Fonts->AddFontFromFileTTF(filename.c_str(), font_info.size_pixels, font_cfg, glyph_ranges);
@@ -69,46 +647,111 @@ namespace Tempo {
                 pair.second->im_font = nullptr;
             }
             FONTM.font_atlas.erase(font_id);
+            FONTM.removeFont((uint32_t)font_id);
+            FONTM.updateFontTable();
         }
     }
 
     void PushFont(FontID font_id, float scale) {
         // assert(app_state.loop_running && "PushFont cannot be called outside of the main loop of the application");
+        // Nothing is allocated or looked up in a map, PushFont can be called for every widget
+        const int depth = FONTM.font_stack_depth++;
+        IM_ASSERT(depth < FontManager::max_font_stack && "Too many nested PushFont");
+        // Beyond the maximum depth, the fonts are ignored (but PopFont must still be called)
+        if (depth >= FontManager::max_font_stack)
+            return;
 
-        FONTM.push_pop_counter++;
-        FontInfo font_info = FONTM.font_atlas[font_id];
-
-        if (FONTM.font_atlas.find(font_id) == FONTM.font_atlas.end()
-            || font_info.multi_scale_font.empty()) {
-            FONTM.ghost_pushes.insert(FONTM.push_pop_counter);
+        if (font_id < 0 || (size_t)font_id >= FONTM.font_table.size()
+            || FONTM.font_table[font_id].fonts.empty()) {
+            FONTM.font_stack[depth] = false;
             return;
         }
+        const FontSlot& slot = FONTM.font_table[font_id];
+
+        // Picks the font rasterized for the DPI of the viewport of the current window
+        // (there are only a few scales, a linear search is the fastest)
+        const float dpi = ImGui::GetWindowViewport()->DpiScale;
+        const std::pair<float, ImFont*>* best = &slot.fonts[0];
+        for (const auto& pair : slot.fonts) {
+            if (std::fabs(pair.first - dpi) < std::fabs(best->first - dpi))
+                best = &pair;
+        }
+        const float font_scale = best->first;
+        ImFont* font = best->second;
+        FONTM.font_stack[depth] = true;
 
-        // FIXME : multiple DPI support
-        ImFont* font = (*(font_info.multi_scale_font.begin())).second->im_font;
+        if (slot.sdf) {
+            // The same distance field is scaled to the size of the font at the DPI of the viewport
+            float dpi_scale = 1.f;
+            if (!slot.no_dpi) {
+#ifdef __APPLE__
+                dpi_scale = FONTM.main_scale;
+#else
+                dpi_scale = dpi;
+#endif
+            }
+            font->Scale = scale * dpi_scale * slot.size_pixels / font->FontSize;
+            ImGui::PushFont(font);
+            return;
+        }
+#ifdef __APPLE__
+        // Compensates io.FontGlobalScale, which is set for the main window scale
+        if (!slot.no_dpi)
+            scale *= FONTM.main_scale / font_scale;
+#else
+        (void)font_scale;
+#endif
         font->Scale = scale;
         ImGui::PushFont(font);
     }
 
     void PopFont() {
         // assert(app_state.loop_running && "PushFont cannot be called outside of the main loop of the application");
-        if (FONTM.ghost_pushes.find(FONTM.push_pop_counter) == FONTM.ghost_pushes.end()) {
+        IM_ASSERT(FONTM.font_stack_depth > 0 && "PopFont without PushFont");
+        if (FONTM.font_stack_depth <= 0)
+            return;
+        const int depth = --FONTM.font_stack_depth;
+        if (depth < FontManager::max_font_stack && FONTM.font_stack[depth])
             ImGui::PopFont();
-        }
-        else {
-            FONTM.ghost_pushes.erase(FONTM.push_pop_counter);
-        }
-        FONTM.push_pop_counter--;
     }
 
-    SafeImFontPtr GetImFont(FontID font_id) {
-        if (font_id == -1) {
+    SafeImFontPtr GetImFont(FontID font_id, float dpi_scale) {
+        auto it = FONTM.font_atlas.find(font_id);
+        if (it == FONTM.font_atlas.end() || it->second.multi_scale_font.empty())
             return std::make_shared<SafeImFont>(SafeImFont{ nullptr });
+        const FontInfo& font_info = it->second;
+        if (dpi_scale <= 0.f)
+            dpi_scale = FONTM.main_scale;
+        return font_info.multi_scale_font.at(FontManager::findScale(font_info, dpi_scale));
+    }
+
+    void RequestGlyphs(const char* text, const char* text_end) {
+        if (FONTM.glyph_cache.request(text, text_end))
+            FONTM.glyphsMissing();
+    }
+
+    void TextUnformatted(const char* text, const char* text_end) {
+        RequestGlyphs(text, text_end);
+        ImGui::TextUnformatted(text, text_end);
+    }
+
+    void SetGlyphCacheBudget(size_t bytes) {
+        FONTM.glyph_cache.setBudget(bytes);
+    }
+
+    GlyphCacheStats GetGlyphCacheStats() {
+        return FONTM.glyph_cache.getStats();
+    }
+
+    FontAtlasStats GetFontAtlasStats() {
+        FontAtlasStats stats = FONTM.stats;
+        stats.texture_bytes = FontManager::textureBytes(*FONTM.front_build);
+        stats.rgba_texture_bytes = FontManager::textureBytes(*FONTM.front_build, true);
+        for (const auto& page : FONTM.pages) {
+            stats.texture_bytes += FontManager::textureBytes(*page);
+            stats.rgba_texture_bytes += FontManager::textureBytes(*page, true);
         }
-        FontInfo font_info = FONTM.font_atlas[font_id];
-        // TODO: multi scale atlas
-        if (font_info.multi_scale_font.empty())
-            return std::make_shared<SafeImFont>(SafeImFont{ nullptr });
-        return font_info.multi_scale_font.begin()->second;
+        stats.pages = FONTM.pages.size();
+        return stats;
     }
 }
\ No newline at end of file
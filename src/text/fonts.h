@@ -21,6 +21,53 @@ namespace Tempo {
     using SafeImFontPtr = std::shared_ptr<SafeImFont>;
     typedef int FontID;
 
+    /**
+     * Flags of the fonts, can be combined
+     */
+    enum fontFlags {
+        FONT_FLAGS_NONE = 0,
+        // The glyph ranges are the glyphs the font may contain, they are only
+        // rasterized once they are used (see RequestGlyphs), e.g. for CJK fonts
+        FONT_FLAGS_DYNAMIC_GLYPHS = 1 << 0,
+        // The glyphs are rasterized once as signed distance fields, and stay sharp at
+        // any scale (PushFont scale, DPI) without rebuilding the atlas. Best for large
+        // or zoomed text, small text is usually crisper with the default bitmap fonts
+        FONT_FLAGS_SDF = 1 << 1
+    };
+
+    /**
+     * Statistics of the glyphs of the dynamic fonts (see FONT_FLAGS_DYNAMIC_GLYPHS)
+     */
+    struct GlyphCacheStats {
+        // Glyphs in the atlas, outside of Basic Latin and Latin-1
+        size_t resident_glyphs = 0;
+        // Number of glyphs that fit in the texture memory budget
+        size_t budget_glyphs = 0;
+        // Estimated texture memory of the resident glyphs (all the dynamic fonts and scales)
+        size_t estimated_bytes = 0;
+        // Requests of glyphs already in the atlas, requests of new glyphs, evicted glyphs
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+    };
+
+    /**
+     * Memory and build time of the font atlases
+     */
+    struct FontAtlasStats {
+        // Texture memory of all the atlases in use (main atlas, pages and SDF atlases)
+        size_t texture_bytes = 0;
+        // Texture memory the same atlases would use if uploaded as RGBA
+        // (see Config::single_channel_font_atlas)
+        size_t rgba_texture_bytes = 0;
+        // Number of atlas pages (see incremental font addition)
+        size_t pages = 0;
+        // Last atlas or page built: time to rasterize and pack it, and its texture memory
+        float last_build_ms = 0.f;
+        size_t last_build_bytes = 0;
+        size_t builds = 0;
+    };
+
     /**
      * @brief Adds a font (from file) that knows the DPI of the current viewport
      *
@@ -34,14 +81,17 @@ namespace Tempo {
      * It is recommended to use the function inside the MainApp::Initialization()
      * or MainApp::BeforeFrameUpdate()
      *
+     * The file is memory-mapped once, and shared by all the fonts, scales and rebuilds using it
+     *
      * @param filename path to the TTF font
      * @param size_pixels relative pixel size of the font
      * @param font_cfg ImGUI font configuration flags
      * @param glyph_ranges ImGUI font ranges for glyphs
      * @param no_dpi if true, is not influenced by dpi changes
-     * @return std::optional<FontID> returns a FontID if it succeeded
+     * @param flags combination of fontFlags
+     * @return std::optional<FontID> returns a FontID if it succeeded (the file could be opened)
      */
-    std::optional<FontID> AddFontFromFileTTF(const std::string& filename, float size_pixels, ImFontConfig font_cfg = ImFontConfig{}, ImVector<ImWchar> glyph_ranges = ImVector<ImWchar>(), bool no_dpi = false);
+    std::optional<FontID> AddFontFromFileTTF(const std::string& filename, float size_pixels, ImFontConfig font_cfg = ImFontConfig{}, ImVector<ImWchar> glyph_ranges = ImVector<ImWchar>(), bool no_dpi = false, int flags = FONT_FLAGS_NONE);
 
 
     /**
@@ -57,49 +107,62 @@ namespace Tempo {
     bool AddIconsToFont(FontID font_id, const std::string& filename, ImFontConfig font_cfg = ImFontConfig{}, ImVector<ImWchar> glyph_ranges = ImVector<ImWchar>());
 
     /**
-     * @brief Adds a font (from memory) that know the DPI of the current viewport
+     * @brief Adds a font (from memory) that knows the DPI of the current viewport
      *
-     * Using these fonts is similar to the ImGUI ImGui::PushFont and ImGui::PopFont,
-     * instead, one must use the equivalent PushDPIAwareFont and PopDPIAwareFont
+     * Same as AddFontFromFileTTF, for fonts embedded in the application (no I/O).
+     * The data is used in place for all the scales and rebuilds of the atlas:
+     * if font_cfg.FontDataOwnedByAtlas is true (default, same as ImGui), the data must
+     * have been allocated with IM_ALLOC and is freed when the font is removed,
+     * otherwise it must stay valid as long as the font exists (e.g. a static array)
      *
      * @param font_data array contained the TTF data
      * @param font_size size of the data array
      * @param size_pixels relative pixel size of the font
      * @param font_cfg ImGUI font configuration flags
      * @param glyph_ranges ImGUI font ranges for glyphs
+     * @param no_dpi if true, is not influenced by dpi changes
+     * @param flags combination of fontFlags
      * @return std::optional<FontID> returns a FontID if it succeeded
      */
-     // std::optional<FontID> AddFontFromMemoryTTF(void* font_data, int font_size, float size_pixels, const ImFontConfig* font_cfg = (const ImFontConfig*)0, const ImWchar* glyph_ranges = (const ImWchar*)0);
-
-     /**
-      * @brief Adds a font (from memory, compressed TTF) that know the DPI of the current viewport
-      *
-      * Using these fonts is similar to the ImGUI ImGui::PushFont and ImGui::PopFont,
-      * instead, one must use the equivalent PushDPIAwareFont and PopDPIAwareFont
-      *
-      * @param compressed_font_data array contained the TTF data
-      * @param compressed_font_size size of the data array
-      * @param size_pixels relative pixel size of the font
-      * @param font_cfg ImGUI font configuration flags
-      * @param glyph_ranges ImGUI font ranges for glyphs
-      * @return std::optional<FontID> returns a FontID if it succeeded
-      */
-      // std::optional<FontID> AddFontFromCompressedMemoryTTF(const void* compressed_font_data, int compressed_font_size, float size_pixels, const ImFontConfig* font_cfg = (const ImFontConfig*)0, const ImWchar* glyph_ranges = (const ImWchar*)0);
-
-      /**
-       * @brief Removes a DPI aware font from the atlas
-       * If the FontID is not registered, this function does nothing
-       *
-       * @param font_id ID of the font, which should have been given by the AddDPIAwareFont* functions
-       */
+    std::optional<FontID> AddFontFromMemoryTTF(void* font_data, int font_size, float size_pixels, ImFontConfig font_cfg = ImFontConfig{}, ImVector<ImWchar> glyph_ranges = ImVector<ImWchar>(), bool no_dpi = false, int flags = FONT_FLAGS_NONE);
+
+    /**
+     * @brief Adds a font (from memory, compressed TTF) that knows the DPI of the current viewport
+     *
+     * The font is decompressed once (see binary_to_compressed_c in ImGui), the
+     * compressed data can be freed after the call
+     *
+     * @param compressed_font_data array contained the TTF data
+     * @param compressed_font_size size of the data array
+     * @param size_pixels relative pixel size of the font
+     * @param font_cfg ImGUI font configuration flags
+     * @param glyph_ranges ImGUI font ranges for glyphs
+     * @param no_dpi if true, is not influenced by dpi changes
+     * @param flags combination of fontFlags
+     * @return std::optional<FontID> returns a FontID if it succeeded
+     */
+    std::optional<FontID> AddFontFromCompressedMemoryTTF(const void* compressed_font_data, int compressed_font_size, float size_pixels, ImFontConfig font_cfg = ImFontConfig{}, ImVector<ImWchar> glyph_ranges = ImVector<ImWchar>(), bool no_dpi = false, int flags = FONT_FLAGS_NONE);
+
+    /**
+     * @brief Removes a DPI aware font from the atlas
+     * If the FontID is not registered, this function does nothing
+     *
+     * @param font_id ID of the font, which should have been given by the AddDPIAwareFont* functions
+     */
     void RemoveFont(FontID font_id);
 
     /**
      * @brief Pushes the DPI aware font to the front of the atlas
      *
+     * The font rasterized for the DPI scale of the viewport of the current
+     * window is used (fonts are built for every connected monitor)
+     *
      * If the FontID is not registered, it pushes the default ImGUI font
      * (and will not be DPI aware)
      *
+     * PushFont does not allocate, it can be called for every widget. At most
+     * 128 fonts can be nested, deeper fonts are ignored
+     *
      * This function should be used inside the main loop
      *
      * @param font_id
@@ -117,10 +180,45 @@ namespace Tempo {
      */
     void PopFont();
 
+    /**
+     * @brief Marks the glyphs of a text as used by the dynamic fonts
+     *
+     * Glyphs that are not in the atlas yet are rasterized in the background,
+     * on a new page of the atlas, and are drawn once it is ready (the fallback glyph is drawn
+     * until then). Characters typed by the user are requested automatically.
+     *
+     * Should be called each frame for the text that is shown, so that
+     * the glyphs are not evicted
+     *
+     * @param text UTF-8 text
+     * @param text_end end of the text, if nullptr the text must be null terminated
+     */
+    void RequestGlyphs(const char* text, const char* text_end = nullptr);
+
+    /**
+     * @brief Same as ImGui::TextUnformatted, and requests the glyphs of the text
+     */
+    void TextUnformatted(const char* text, const char* text_end = nullptr);
+
+    /**
+     * @brief Sets the texture memory that the glyphs of the dynamic fonts may use
+     * (64 MB by default), the least recently used glyphs are evicted above it
+     */
+    void SetGlyphCacheBudget(size_t bytes);
+
+    GlyphCacheStats GetGlyphCacheStats();
+
+    FontAtlasStats GetFontAtlasStats();
+
     /**
      * @brief Returns the corresponding im font ptr from Tempo's font id
      *
+     * Each font exists once per monitor DPI scale, the font
+     * with the closest scale is returned
+     *
      * @param font_id
+     * @param dpi_scale DPI scale of the viewport (e.g. ImGuiViewport::DpiScale),
+     * if 0, the content scale of the main window is used
      */
-    SafeImFontPtr GetImFont(FontID font_id);
+    SafeImFontPtr GetImFont(FontID font_id, float dpi_scale = 0.f);
 }
\ No newline at end of file
@@ -1,39 +1,256 @@
 #pragma once
 #include "fonts.h"
+#include "glyph_cache.h"
+#include "../mapped_file.h"
+#include <array>
+#include <functional>
 #include <map>
+#include <memory>
 #include <vector>
 #include <set>
 #include <string>
 #include <optional>
 
 namespace Tempo {
+    struct AtlasCacheData;
+
+    /**
+     * @brief Content of a font (TTF/OTF), shared by all the scales and builds of the fonts using it
+     *
+     * Font files are memory-mapped once, fonts given from memory are used in place
+     * (compressed fonts are decompressed once). The data is never owned by an ImFontAtlas,
+     * and is freed when the last font (or atlas being built) using it is gone
+     */
+    struct FontData {
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        // Hash of the content of the fonts from memory (files are checked by their stamp)
+        uint64_t hash = 0;
+        std::unique_ptr<MappedFile> file;
+        // Allocated by ImGui (IM_ALLOC), freed with the FontData
+        void* owned_data = nullptr;
+
+        FontData() = default;
+        ~FontData();
+        FontData(FontData const&) = delete;
+        void operator=(FontData const&) = delete;
+    };
+    using FontDataPtr = std::shared_ptr<const FontData>;
+
     struct FontInfo {
         std::map<float, SafeImFontPtr> multi_scale_font;
         float scaling = 0;
         // Font parameters for ImGui
         std::string filename;
+        // Content of the font, filename is empty for fonts from memory
+        FontDataPtr data;
         float size_pixels;
         bool no_dpi = false;
+        int flags = FONT_FLAGS_NONE;
         ImFontConfig font_cfg;
         ImVector<ImWchar> glyph_ranges;
         std::vector<FontInfo> icons; // Can add multiple icons to a font
     };
 
-    struct Fonts {
-        int push_pop_counter = 0;
-        bool reconstruct_fonts = true;
-        std::set<int> ghost_pushes;
-        int font_counter = 0;
-        std::map<uint32_t, FontInfo> font_atlas;
+    /**
+     * @brief Font atlas, with the parameters of the fonts it has been built from
+     *
+     * The ImFontAtlas keeps pointers to the glyph ranges of the fonts,
+     * this is why the parameters live as long as the atlas
+     */
+    struct FontAtlasBuild {
+        ImFontAtlas atlas;
+        // Fonts with FONT_FLAGS_SDF, drawn with the SDF shader (see sdf_font.h)
+        ImFontAtlas sdf_atlas;
+        std::vector<float> scales;
+        // Copy of FontManager::font_atlas, multi_scale_font contains the ImFont* of this atlas
+        std::map<uint32_t, FontInfo> fonts;
+        // Fonts of this atlas which are still used (not removed or rebuilt in another atlas)
+        std::set<uint32_t> live_fonts;
+        bool built = false;
+        // On-disk cache of the atlas (see atlas_cache.h), no cache if the path is empty
+        std::string cache_path;
+        uint64_t cache_key = 0;
+        bool from_cache = false;
+        // Serialized by the build, written to the cache by a job once the atlas is swapped
+        std::shared_ptr<AtlasCacheData> cache_data;
+        // Time to rasterize and pack the atlases
+        float build_ms = 0.f;
+    };
+
+    /**
+     * @brief ImFont* of a font at each of its scales, read by PushFont without any lookup in a map
+     */
+    struct FontSlot {
+        // Sorted by scale, empty if the font is not registered or not built yet
+        std::vector<std::pair<float, ImFont*>> fonts;
+        float size_pixels = 0.f;
+        bool no_dpi = false;
+        bool sdf = false;
     };
 
     struct FontManager {
-        int push_pop_counter = 0;
         bool reconstruct_fonts = true;
-        std::set<int> ghost_pushes;
         int font_counter = 0;
         std::map<uint32_t, FontInfo> font_atlas;
 
+        // Flat copy of font_atlas indexed by FontID, rebuilt when the atlas or the fonts change
+        std::vector<FontSlot> font_table;
+        // Maximum number of nested PushFont
+        static constexpr int max_font_stack = 128;
+        // For each nested PushFont, whether a font has been pushed to ImGui (false for unknown fonts)
+        std::array<bool, max_font_stack> font_stack{};
+        int font_stack_depth = 0;
+
+        // DPI scales for which the fonts are built (all the monitors seen since the start)
+        // Scales are never removed, so moving a window between monitors does not rebuild the atlas
+        std::set<float> scales;
+        // Content scale of the main window
+        float main_scale = 1.f;
+
+        // Glyphs of the fonts with FONT_FLAGS_DYNAMIC_GLYPHS
+        GlyphCache glyph_cache;
+
+        /**
+         * @brief Registers a DPI scale for which the fonts must exist
+         * If the scale is new, the atlas will be rebuilt
+         *
+         * @param scale content scale of a monitor or a window
+         */
+        void addScale(float scale);
+
+        // Atlas used by ImGui (io.Fonts), and atlas in which the next one is built
+        // While a build is running, the back atlas is only touched by the worker
+        std::shared_ptr<FontAtlasBuild> front_build = std::make_shared<FontAtlasBuild>();
+        std::shared_ptr<FontAtlasBuild> back_build = std::make_shared<FontAtlasBuild>();
+        bool build_in_background = true;
+        bool building = false;
+        // File in which the last atlas is cached, to skip the rasterization at the next start
+        std::string cache_path;
+        // Set when an atlas built in the background has been swapped in
+        bool atlas_swapped = false;
+        // Incremented each time an atlas or a page is swapped in (the ImFont change)
+        uint64_t atlas_generation = 0;
+
+        // Additional atlases (pages), each with its own texture, in which the fonts added
+        // or changed after the main atlas has been built are appended
+        std::vector<std::shared_ptr<FontAtlasBuild>> pages;
+        // Fonts to build on a new page
+        std::set<uint32_t> pending_fonts;
+        // The atlas is compacted (fully rebuilt) once this share of the glyphs belongs to removed
+        // fonts, or once there are too many pages
+        float compaction_threshold = 0.5f;
+        size_t max_pages = 8;
+
+        FontAtlasStats stats;
+
+        // Mapped font files, shared by the fonts (and icons) using the same file
+        std::map<std::string, std::weak_ptr<const FontData>> mapped_files;
+
+        /**
+         * @brief Maps the font file, or returns the mapping already used by another font
+         * @return nullptr if the file cannot be opened
+         */
+        FontDataPtr mapFontFile(const std::string& filename);
+
+        /**
+         * @return atlas to give to ImGui::CreateContext, which stays owned by the FontManager
+         */
+        ImFontAtlas* getAtlas() {
+            return &front_build->atlas;
+        }
+
+        /**
+         * @brief Brings the atlases up to date, called before each frame
+         *
+         * New or changed fonts are built on a new page, without touching the
+         * glyphs of the other fonts. The whole atlas is rebuilt for the first build,
+         * a new scale, new glyphs of dynamic fonts, or when it must be compacted.
+         * Pages without fonts left are destroyed.
+         */
+        void update();
+
+        /**
+         * @brief Rebuilds the atlas with every font at every registered scale
+         *
+         * The first atlas is built immediately, or loaded from the cache file if the fonts
+         * did not change since it was written (the font files are then checked by a worker,
+         * and the atlas is rebuilt if they changed). The next ones are built by a worker
+         * of the JobScheduler, while the current atlas is still used, and swapped
+         * in by JobScheduler::finalizeJobs once they are ready.
+         * If a build is already running, the atlas is rebuilt after it
+         */
+        void buildAtlas();
+
+        /**
+         * @brief Builds the pending fonts on a new page (by a worker, like buildAtlas)
+         */
+        void buildPage();
+
+        /**
+         * @brief Adds every font at every scale to the atlas, and builds it
+         * The built atlas is then written to the cache file (if any)
+         * Does not use the ImGui context, can be called from any thread
+         */
+        static void build(FontAtlasBuild& build);
+
+        /**
+         * @brief Makes the back atlas the one used by ImGui, and uploads its texture
+         * The SafeImFont of the fonts are updated in place
+         */
+        void swapAtlas();
+
+        /**
+         * @brief Uploads the texture of a built page, and makes its fonts the ones in use
+         */
+        void addPage(std::shared_ptr<FontAtlasBuild> page);
+
+        /**
+         * @brief Rebuilds the dynamic fonts on a new page, after glyphs missing from the atlas
+         * have been requested
+         * Compacts the atlas instead if the requested glyphs exceed the glyph cache budget
+         */
+        void glyphsMissing();
+
+        /**
+         * @brief Marks the font as removed in all the atlases
+         * Compacts the atlas if too many glyphs belong to removed fonts
+         */
+        void removeFont(uint32_t font_id);
+
+        /**
+         * @return share of the glyph surface (0 to 1) of all the atlases that belongs to removed fonts
+         */
+        float getFragmentation() const;
+
+        /**
+         * @brief Destroys the textures of the pages
+         */
+        void destroyPages();
+
+        /**
+         * @brief Destroys the textures of the pages and of the SDF fonts, before the OpenGL context is destroyed
+         * (the texture of io.Fonts is destroyed by ImGui)
+         */
+        void destroyTextures();
+
+        /**
+         * @return texture memory of the atlases of the build, as uploaded (or if they were uploaded as RGBA)
+         */
+        static size_t textureBytes(FontAtlasBuild& build, bool as_rgba = false);
+
+        /**
+         * @brief Copies the ImFont* of the fonts into font_table
+         * Called each time an ImFont* of font_atlas changes, or a font is added or removed
+         */
+        void updateFontTable();
+
+        /**
+         * @return the scale of the font that is the closest to the given DPI scale,
+         * or 0 if the font has not been built
+         */
+        static float findScale(const FontInfo& font, float dpi_scale);
+
         /**
          * Copy constructors stay empty, because of the Singleton
          */
@@ -49,6 +266,33 @@ namespace Tempo {
         }
     private:
         FontManager() = default;
+
+        /**
+         * Checks the content of the font files of the cached atlas on a worker,
+         * and rebuilds the atlas if they changed
+         */
+        void validate_cache();
+
+        /**
+         * Writes the serialized atlas of the build to the cache on a worker
+         */
+        void save_cache(FontAtlasBuild& build);
+
+        /**
+         * Copies the parameters of the fonts into a build (all the fonts, or the pending ones)
+         */
+        void prepare_build(FontAtlasBuild& build, bool all_fonts);
+
+        /**
+         * Runs the build on a worker (or immediately if not in background), then calls on_built
+         */
+        void run_build(std::shared_ptr<FontAtlasBuild> build, std::function<void(std::shared_ptr<FontAtlasBuild>)> on_built);
+
+        /**
+         * Points the SafeImFont of the fonts of the build to its ImFont*,
+         * and marks these fonts as not used anymore in the other atlases
+         */
+        void bind_fonts(FontAtlasBuild& build);
     };
 
 #define FONTM FontManager::getInstance()
@@ -0,0 +1,214 @@
+#include "glyph_cache.h"
+#include "fonts_private.h"
+#include "sdf_font.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Tempo {
+    namespace {
+        // Basic Latin + Latin Supplement, always in the dynamic fonts
+        constexpr unsigned int base_first = 0x0020;
+        constexpr unsigned int base_last = 0x00FF;
+
+        bool in_ranges(const ImWchar* ranges, unsigned int codepoint) {
+            for (; ranges[0] != 0; ranges += 2) {
+                if (codepoint >= ranges[0] && codepoint <= ranges[1])
+                    return true;
+            }
+            return false;
+        }
+
+        /*
+         * Decodes one UTF-8 character
+         * Invalid sequences are skipped one byte at a time
+         */
+        const char* next_codepoint(const char* text, const char* text_end, unsigned int& codepoint) {
+            const unsigned char c = (unsigned char)*text;
+            int length = 1;
+            if (c < 0x80) {
+                codepoint = c;
+                return text + 1;
+            }
+            if ((c & 0xE0) == 0xC0) {
+                codepoint = c & 0x1F;
+                length = 2;
+            }
+            else if ((c & 0xF0) == 0xE0) {
+                codepoint = c & 0x0F;
+                length = 3;
+            }
+            else if ((c & 0xF8) == 0xF0) {
+                codepoint = c & 0x07;
+                length = 4;
+            }
+            else {
+                codepoint = 0;
+                return text + 1;
+            }
+            if (text_end - text < length) {
+                codepoint = 0;
+                return text_end;
+            }
+            for (int i = 1; i < length; i++) {
+                const unsigned char next = (unsigned char)text[i];
+                if ((next & 0xC0) != 0x80) {
+                    codepoint = 0;
+                    return text + 1;
+                }
+                codepoint = (codepoint << 6) | (next & 0x3F);
+            }
+            return text + length;
+        }
+    }
+
+    void GlyphCache::update(const std::map<uint32_t, FontInfo>& fonts, const std::vector<float>& scales) {
+        enabled_ = false;
+        glyph_cost_ = 0;
+        for (const auto& font_pair : fonts) {
+            const FontInfo& font = font_pair.second;
+            if (!(font.flags & FONT_FLAGS_DYNAMIC_GLYPHS) || font.glyph_ranges.empty())
+                continue;
+            if (!enabled_) {
+                enabled_ = true;
+                allowed_.assign(IM_UNICODE_CODEPOINT_MAX + 1, false);
+                if (last_use_.empty()) {
+                    last_use_.assign(IM_UNICODE_CODEPOINT_MAX + 1, 0);
+                    in_atlas_.assign(IM_UNICODE_CODEPOINT_MAX + 1, false);
+                }
+            }
+            for (const ImWchar* range = &font.glyph_ranges[0]; range[0] != 0; range += 2) {
+                for (unsigned int c = range[0]; c <= range[1] && c <= IM_UNICODE_CODEPOINT_MAX; c++) {
+                    allowed_[c] = true;
+                }
+            }
+
+            // Each glyph is rasterized once per scale, and uploaded as RGBA in the worst case
+            const ImFontConfig& cfg = font.font_cfg;
+            if (font.flags & FONT_FLAGS_SDF) {
+                // Once for all the scales
+                const size_t size = (size_t)SdfFontBuilder::font_size + 2 * SdfFontBuilder::padding;
+                glyph_cost_ += size * size * 4;
+                continue;
+            }
+            for (float scale : scales) {
+                if (font.no_dpi)
+                    scale = 1.f;
+                const size_t size = (size_t)std::ceil(font.size_pixels * scale);
+                glyph_cost_ += (size * (size_t)cfg.OversampleH + 1) * (size * (size_t)cfg.OversampleV + 1) * 4;
+                if (font.no_dpi)
+                    break;
+            }
+        }
+        if (!enabled_) {
+            allowed_.clear();
+            resident_.clear();
+            in_atlas_.assign(in_atlas_.size(), false);
+            return;
+        }
+
+        for (unsigned int c = base_first; c <= base_last; c++) {
+            in_atlas_[c] = true;
+        }
+        // Glyphs which are not allowed anymore (font removed)
+        auto removed = std::remove_if(resident_.begin(), resident_.end(), [this](ImWchar c) {
+            return !allowed_[c];
+            });
+        for (auto it = removed; it != resident_.end(); it++) {
+            in_atlas_[*it] = false;
+        }
+        resident_.erase(removed, resident_.end());
+    }
+
+    bool GlyphCache::request(unsigned int codepoint) {
+        if (codepoint >= allowed_.size() || !allowed_[codepoint])
+            return false;
+        last_use_[codepoint] = frame_;
+        if (in_atlas_[codepoint]) {
+            stats_.hits++;
+            return false;
+        }
+        in_atlas_[codepoint] = true;
+        resident_.push_back((ImWchar)codepoint);
+        stats_.misses++;
+        return true;
+    }
+
+    bool GlyphCache::request(const char* text, const char* text_end) {
+        if (!enabled_ || text == nullptr)
+            return false;
+        if (text_end == nullptr)
+            text_end = text + strlen(text);
+        bool missing = false;
+        while (text < text_end) {
+            unsigned int codepoint;
+            text = next_codepoint(text, text_end, codepoint);
+            // ASCII is always in the atlas
+            if (codepoint > base_last)
+                missing |= request(codepoint);
+        }
+        return missing;
+    }
+
+    void GlyphCache::evict() {
+        if (glyph_cost_ == 0)
+            return;
+        const size_t max_glyphs = budget_ / glyph_cost_;
+        if (resident_.size() <= max_glyphs)
+            return;
+
+        // The most recently used glyphs are moved to the front
+        auto keep = resident_.begin() + (std::ptrdiff_t)max_glyphs;
+        std::nth_element(resident_.begin(), keep, resident_.end(), [this](ImWchar a, ImWchar b) {
+            return last_use_[a] > last_use_[b];
+            });
+        auto removed = std::stable_partition(keep, resident_.end(), [this](ImWchar c) {
+            return last_use_[c] == frame_;
+            });
+        for (auto it = removed; it != resident_.end(); it++) {
+            in_atlas_[*it] = false;
+            stats_.evictions++;
+        }
+        resident_.erase(removed, resident_.end());
+    }
+
+    ImVector<ImWchar> GlyphCache::getRanges(const FontInfo& font) const {
+        const ImWchar* allowed = &font.glyph_ranges[0];
+        std::vector<unsigned int> codepoints;
+        codepoints.reserve(resident_.size() + base_last - base_first + 1);
+        for (unsigned int c = base_first; c <= base_last; c++) {
+            if (in_ranges(allowed, c))
+                codepoints.push_back(c);
+        }
+        for (ImWchar c : resident_) {
+            if (in_ranges(allowed, c))
+                codepoints.push_back(c);
+        }
+        // A font needs at least one glyph
+        if (codepoints.empty())
+            codepoints.push_back(base_first);
+        std::sort(codepoints.begin(), codepoints.end());
+
+        // Consecutive codepoints are merged into one range
+        ImVector<ImWchar> ranges;
+        for (size_t i = 0; i < codepoints.size();) {
+            size_t j = i;
+            while (j + 1 < codepoints.size() && codepoints[j + 1] <= codepoints[j] + 1)
+                j++;
+            ranges.push_back((ImWchar)codepoints[i]);
+            ranges.push_back((ImWchar)codepoints[j]);
+            i = j + 1;
+        }
+        ranges.push_back(0);
+        return ranges;
+    }
+
+    GlyphCacheStats GlyphCache::getStats() const {
+        GlyphCacheStats stats = stats_;
+        stats.resident_glyphs = resident_.size();
+        stats.budget_glyphs = glyph_cost_ == 0 ? 0 : budget_ / glyph_cost_;
+        stats.estimated_bytes = resident_.size() * glyph_cost_;
+        return stats;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "fonts.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Tempo {
+    struct FontInfo;
+
+    /**
+     * @brief Glyphs of the dynamic fonts (FONT_FLAGS_DYNAMIC_GLYPHS) that are in the atlas
+     *
+     * The glyph ranges given to a dynamic font are the glyphs it is allowed to contain.
+     * Only Basic Latin and Latin-1 are always in the atlas, the other glyphs are added
+     * when they are requested (text shown with RequestGlyphs, typed characters), and
+     * the dynamic fonts are then rebuilt on a new page in the background with them.
+     *
+     * When the estimated texture memory of the requested glyphs exceeds the budget,
+     * the atlas is compacted and the least recently used glyphs are evicted.
+     *
+     * All the functions must be called from the main thread
+     */
+    class GlyphCache {
+    private:
+        // Frame at which each codepoint has been requested for the last time (0 = never)
+        std::vector<uint32_t> last_use_;
+        // Codepoints that are in the glyph ranges of at least one dynamic font
+        std::vector<bool> allowed_;
+        // Codepoints in the atlas, or in the atlas being built
+        std::vector<bool> in_atlas_;
+        // Requested codepoints (outside of the always present ones)
+        std::vector<ImWchar> resident_;
+
+        uint32_t frame_ = 1;
+        bool enabled_ = false;
+        size_t budget_ = 64 * 1024 * 1024;
+        // Estimated texture memory of one glyph, in all the dynamic fonts and scales
+        size_t glyph_cost_ = 0;
+
+        GlyphCacheStats stats_;
+
+    public:
+        /**
+         * @brief Updates the allowed glyphs and the cost of a glyph from the fonts
+         * Called before each build of the atlas
+         */
+        void update(const std::map<uint32_t, FontInfo>& fonts, const std::vector<float>& scales);
+
+        /**
+         * @return true if at least one font has dynamic glyphs
+         */
+        bool isEnabled() const { return enabled_; }
+
+        void newFrame() { frame_++; }
+
+        /**
+         * @brief Marks the glyph as used in this frame
+         * @return true if the glyph is not in the atlas yet (the atlas must be rebuilt)
+         */
+        bool request(unsigned int codepoint);
+
+        /**
+         * @brief Marks all the glyphs of an UTF-8 text as used in this frame
+         * @return true if at least one glyph is not in the atlas yet
+         */
+        bool request(const char* text, const char* text_end);
+
+        /**
+         * @brief Evicts the least recently used glyphs until they fit in the budget
+         * Glyphs used in the current frame are never evicted
+         */
+        void evict();
+
+        /**
+         * @return glyph ranges with which the dynamic font must be built
+         */
+        ImVector<ImWchar> getRanges(const FontInfo& font) const;
+
+        void setBudget(size_t bytes) { budget_ = bytes; }
+
+        /**
+         * @return true if the requested glyphs exceed the budget (they must be evicted)
+         */
+        bool isOverBudget() const { return glyph_cost_ != 0 && resident_.size() * glyph_cost_ > budget_; }
+
+        GlyphCacheStats getStats() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "sdf_font.h"
+#include "fonts_private.h"
+
+#include <cmath>
+#include <cstring>
+
+// Private copy of stb_truetype (ImGui compiles its own as static too),
+// for stbtt_GetGlyphSDF which is not exposed by the ImGui atlas
+#define STBTT_malloc(x,u)   ((void)(u), IM_ALLOC(x))
+#define STBTT_free(x,u)     ((void)(u), IM_FREE(x))
+#define STBTT_assert(x)     do { IM_ASSERT(x); } while(0)
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "imstb_truetype.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace Tempo {
+    int SdfFontBuilder::addGlyphs(ImFontAtlas& atlas, ImFont* font, const FontData& data, const ImFontConfig& cfg, const ImWchar* ranges) {
+        if (font == nullptr || data.data == nullptr || ranges == nullptr)
+            return 0;
+
+        stbtt_fontinfo info;
+        const int offset = stbtt_GetFontOffsetForIndex(data.data, cfg.FontNo);
+        if (offset < 0 || !stbtt_InitFont(&info, data.data, offset))
+            return 0;
+
+        // Same metrics as the glyphs rasterized by ImGui (ImFontAtlasBuildWithStbTruetype)
+        const float scale = stbtt_ScaleForPixelHeight(&info, font_size);
+        int unscaled_ascent, unscaled_descent, unscaled_line_gap;
+        stbtt_GetFontVMetrics(&info, &unscaled_ascent, &unscaled_descent, &unscaled_line_gap);
+        const float ascent = std::floor(unscaled_ascent * scale + ((unscaled_ascent > 0) ? +1 : -1));
+        const float offset_y = cfg.GlyphOffset.y + std::round(ascent);
+
+        int count = 0;
+        for (; ranges[0] != 0; ranges += 2) {
+            for (unsigned int codepoint = ranges[0]; codepoint <= ranges[1] && codepoint <= IM_UNICODE_CODEPOINT_MAX; codepoint++) {
+                // The space is rasterized by ImGui, so that the font is not empty
+                if (codepoint == ' ')
+                    continue;
+                const int glyph_index = stbtt_FindGlyphIndex(&info, (int)codepoint);
+                if (glyph_index == 0)
+                    continue;
+
+                int advance, left_side_bearing;
+                stbtt_GetGlyphHMetrics(&info, glyph_index, &advance, &left_side_bearing);
+                const float advance_x = advance * scale + cfg.GlyphExtraSpacing.x;
+
+                Glyph glyph;
+                int xoff = 0, yoff = 0;
+                unsigned char* bitmap = stbtt_GetGlyphSDF(&info, scale, glyph_index, padding, edge_value,
+                    (float)edge_value / (float)padding, &glyph.width, &glyph.height, &xoff, &yoff);
+                if (bitmap == nullptr) {
+                    // Blank glyph (e.g. other spaces), only the advance matters
+                    glyph.width = 1;
+                    glyph.height = 1;
+                    glyph.pixels.assign(1, 0);
+                }
+                else {
+                    glyph.pixels.assign(bitmap, bitmap + glyph.width * glyph.height);
+                    stbtt_FreeSDF(bitmap, info.userdata);
+                }
+                glyph.rect_id = atlas.AddCustomRectFontGlyph(font, (ImWchar)codepoint, glyph.width, glyph.height, advance_x,
+                    ImVec2(cfg.GlyphOffset.x + (float)xoff, offset_y + (float)yoff));
+                glyphs_.push_back(std::move(glyph));
+                count++;
+            }
+        }
+        return count;
+    }
+
+    void SdfFontBuilder::finish(ImFontAtlas& atlas) {
+        for (const Glyph& glyph : glyphs_) {
+            const ImFontAtlasCustomRect* rect = atlas.GetCustomRectByIndex(glyph.rect_id);
+            if (rect == nullptr || rect->X == 0xFFFF)
+                continue;
+            for (int y = 0; y < glyph.height; y++) {
+                const unsigned char* src = &glyph.pixels[(size_t)(y * glyph.width)];
+                const size_t dst = (size_t)(rect->Y + y) * (size_t)atlas.TexWidth + rect->X;
+                if (atlas.TexPixelsAlpha8 != nullptr) {
+                    std::memcpy(atlas.TexPixelsAlpha8 + dst, src, (size_t)glyph.width);
+                }
+                else if (atlas.TexPixelsRGBA32 != nullptr) {
+                    for (int x = 0; x < glyph.width; x++) {
+                        atlas.TexPixelsRGBA32[dst + x] = IM_COL32(255, 255, 255, src[x]);
+                    }
+                }
+            }
+        }
+        glyphs_.clear();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <imgui.h>
+#include <vector>
+
+namespace Tempo {
+    struct FontData;
+
+    /**
+     * @brief Rasterizes the glyphs of the SDF fonts (FONT_FLAGS_SDF) as signed distance fields
+     *
+     * The legacy ImGui atlas only rasterizes bitmaps, so the distance fields are
+     * computed with stb_truetype and packed as custom glyph rects of the ImFont.
+     * The atlas of the SDF fonts must be drawn with the SDF shader of the renderer
+     * (see ImGui_ImplOpenGL3_CreateFontAtlasTexture), which keeps the text sharp
+     * at any ImFont::Scale.
+     *
+     * Can be used from a worker, like the build of the atlas
+     *
+     * @code{.cpp}
+     * SdfFontBuilder builder;
+     * ImFont* font = atlas.AddFontFromMemoryTTF(...); // with only the space glyph
+     * builder.addGlyphs(atlas, font, data, cfg, ranges);
+     * atlas.Build();
+     * builder.finish(atlas);
+     * @endcode
+     */
+    class SdfFontBuilder {
+    private:
+        struct Glyph {
+            int rect_id;
+            int width;
+            int height;
+            std::vector<unsigned char> pixels;
+        };
+        std::vector<Glyph> glyphs_;
+
+    public:
+        // Pixel size at which the distance fields are computed, for all the sizes of the font
+        static constexpr float font_size = 48.f;
+        // Distance (in pixels) covered by the field around the outline of the glyphs
+        static constexpr int padding = 4;
+        // Value of the outline in the field (the renderer expects 0.5)
+        static constexpr unsigned char edge_value = 128;
+
+        /**
+         * @brief Adds the glyphs of the ranges to the font, as custom rects of the atlas
+         * Must be called before the atlas is built, the font must have been added at font_size
+         *
+         * @param font font of the atlas which receives the glyphs
+         * @param data content of the TTF to rasterize (the font itself, or an icon set)
+         * @param cfg configuration of the font, glyph offsets and spacing in pixels at font_size
+         * @param ranges glyph ranges (0 terminated)
+         * @return number of glyphs added
+         */
+        int addGlyphs(ImFontAtlas& atlas, ImFont* font, const FontData& data, const ImFontConfig& cfg, const ImWchar* ranges);
+
+        /**
+         * @brief Copies the distance fields in the pixels of the built atlas
+         */
+        void finish(ImFontAtlas& atlas);
+    };
+}
\ No newline at end of file
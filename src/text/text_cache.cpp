@@ -0,0 +1,172 @@
+#include "text_cache.h"
+#include "fonts_private.h"
+#include "../mapped_file.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace Tempo {
+    namespace {
+        void draw_layout(const TextLayout& layout, const char* text, const char* text_end) {
+            ImDrawList* draw_list = ImGui::GetWindowDrawList();
+            const ImVec2 pos = ImGui::GetCursorScreenPos();
+            if (ImGui::IsRectVisible(layout.size)) {
+                RequestGlyphs(text, text_end);
+                ImFont* font = ImGui::GetFont();
+                const float font_size = ImGui::GetFontSize();
+                const ImU32 color = ImGui::GetColorU32(ImGuiCol_Text);
+                const float clip_min_y = draw_list->GetClipRectMin().y;
+                const float clip_max_y = draw_list->GetClipRectMax().y;
+                for (size_t i = 0; i < layout.lines.size(); i++) {
+                    const float y = pos.y + (float)i * font_size;
+                    // Only the visible lines of long texts are drawn
+                    if (y + font_size < clip_min_y)
+                        continue;
+                    if (y > clip_max_y)
+                        break;
+                    const auto& line = layout.lines[i];
+                    draw_list->AddText(font, font_size, ImVec2(pos.x, y), color, text + line.first, text + line.second);
+                }
+            }
+            ImGui::Dummy(layout.size);
+        }
+    }
+
+    size_t TextLayoutCache::KeyHash::operator()(const Key& key) const {
+        uint64_t hash = key.hash;
+        hash = hashBytes(&key.font, sizeof(key.font), hash);
+        hash = hashBytes(&key.font_size, sizeof(key.font_size), hash);
+        hash = hashBytes(&key.wrap_width, sizeof(key.wrap_width), hash);
+        return (size_t)hash;
+    }
+
+    void TextLayoutCache::layout(TextLayout& layout, ImFont* font, float font_size, const char* text, const char* text_end, float wrap_width) {
+        // Same line breaks as ImFont::CalcTextSizeA and ImFont::RenderText
+        const float scale = font_size / font->FontSize;
+        float width = 0.f;
+        layout.lines.clear();
+        const char* s = text;
+        while (true) {
+            const char* line_end = (const char*)memchr(s, '\n', (size_t)(text_end - s));
+            if (line_end == nullptr)
+                line_end = text_end;
+            const char* end = line_end;
+            if (wrap_width > 0.f) {
+                end = font->CalcWordWrapPositionA(scale, s, line_end, wrap_width);
+                // A word which is too long for the line is cut, at least one character is consumed
+                if (end == s && s < line_end)
+                    end++;
+            }
+            layout.lines.emplace_back((uint32_t)(s - text), (uint32_t)(end - text));
+            width = std::max(width, font->CalcTextSizeA(font_size, FLT_MAX, 0.f, s, end).x);
+
+            s = end;
+            if (end < line_end) {
+                // The blanks at the start of a wrapped line are skipped
+                while (s < line_end && (*s == ' ' || *s == '\t'))
+                    s++;
+            }
+            if (s == line_end) {
+                if (line_end == text_end)
+                    break;
+                s = line_end + 1;
+                // No empty line after a final '\n', as in ImFont::CalcTextSizeA
+                if (s == text_end)
+                    break;
+            }
+        }
+        // Rounded like ImGui::CalcTextSize
+        layout.size = ImVec2(std::floor(width + 0.99999f), font_size * (float)layout.lines.size());
+    }
+
+    const TextLayout& TextLayoutCache::get(const char* text, const char* text_end, float wrap_width) {
+        // The ImFont may have been rebuilt (other glyphs), or freed and reused
+        if (generation_ != FONTM.atlas_generation) {
+            if (!entries_.empty())
+                stats_.invalidations++;
+            clear();
+            generation_ = FONTM.atlas_generation;
+        }
+        if (text_end == nullptr)
+            text_end = text + strlen(text);
+
+        Key key;
+        key.font = ImGui::GetFont();
+        key.font_size = ImGui::GetFontSize();
+        key.wrap_width = wrap_width > 0.f ? wrap_width : 0.f;
+        key.length = (size_t)(text_end - text);
+        key.hash = hashBytes(text, key.length);
+
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            stats_.hits++;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->second;
+        }
+
+        stats_.misses++;
+        if (index_.size() >= capacity_ && !entries_.empty()) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+            stats_.evictions++;
+        }
+        entries_.emplace_front(key, TextLayout{});
+        index_[key] = entries_.begin();
+        TextLayout& text_layout = entries_.front().second;
+        layout(text_layout, ImGui::GetFont(), key.font_size, text, text_end, key.wrap_width);
+        return text_layout;
+    }
+
+    void TextLayoutCache::setCapacity(size_t entries) {
+        capacity_ = std::max(entries, (size_t)1);
+        while (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+            stats_.evictions++;
+        }
+    }
+
+    void TextLayoutCache::clear() {
+        entries_.clear();
+        index_.clear();
+    }
+
+    TextCacheStats TextLayoutCache::getStats() const {
+        TextCacheStats stats = stats_;
+        stats.entries = entries_.size();
+        stats.capacity = capacity_;
+        return stats;
+    }
+
+    ImVec2 CalcTextSize(const char* text, const char* text_end, float wrap_width) {
+        return TextLayoutCache::getInstance().get(text, text_end, wrap_width).size;
+    }
+
+    const TextLayout& CalcTextLayout(const char* text, const char* text_end, float wrap_width) {
+        return TextLayoutCache::getInstance().get(text, text_end, wrap_width);
+    }
+
+    void TextCached(const char* text, const char* text_end) {
+        if (text_end == nullptr)
+            text_end = text + strlen(text);
+        draw_layout(TextLayoutCache::getInstance().get(text, text_end, 0.f), text, text_end);
+    }
+
+    void TextWrappedCached(const char* text, const char* text_end, float wrap_width) {
+        if (text_end == nullptr)
+            text_end = text + strlen(text);
+        if (wrap_width <= 0.f)
+            wrap_width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+        draw_layout(TextLayoutCache::getInstance().get(text, text_end, wrap_width), text, text_end);
+    }
+
+    void SetTextCacheCapacity(size_t entries) {
+        TextLayoutCache::getInstance().setCapacity(entries);
+    }
+
+    TextCacheStats GetTextCacheStats() {
+        return TextLayoutCache::getInstance().getStats();
+    }
+}
\ No newline at end of file
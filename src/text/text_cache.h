@@ -0,0 +1,137 @@
+#pragma once
+
+#include <imgui.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Tempo {
+    /**
+     * @brief Measured size of a text, and its lines after wrapping
+     */
+    struct TextLayout {
+        ImVec2 size;
+        // Start and end of each line (byte offsets in the text), without the skipped blanks
+        std::vector<std::pair<uint32_t, uint32_t>> lines;
+    };
+
+    /**
+     * Statistics of the text layout cache
+     */
+    struct TextCacheStats {
+        size_t entries = 0;
+        size_t capacity = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        // Number of times the cache has been cleared because the font atlas changed
+        size_t invalidations = 0;
+
+        float hitRate() const {
+            return hits + misses == 0 ? 0.f : (float)hits / (float)(hits + misses);
+        }
+    };
+
+    /**
+     * @brief LRU cache of the layout (size and line breaks) of texts
+     *
+     * Texts are identified by the font (the ImFont of a FontID at a DPI scale), the
+     * font size (PushFont scale), the hash and length of the string, and the wrap width.
+     * The cache is cleared each time a font atlas is built, because the ImFont and
+     * their glyphs change.
+     *
+     * Must be used from the main thread
+     */
+    class TextLayoutCache {
+    private:
+        struct Key {
+            const ImFont* font;
+            float font_size;
+            float wrap_width;
+            uint64_t hash;
+            size_t length;
+
+            bool operator==(const Key& other) const {
+                return font == other.font && font_size == other.font_size && wrap_width == other.wrap_width
+                    && hash == other.hash && length == other.length;
+            }
+        };
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+        using Entry = std::pair<Key, TextLayout>;
+
+        // Most recently used first
+        std::list<Entry> entries_;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+        size_t capacity_ = 16384;
+        uint64_t generation_ = 0;
+        TextCacheStats stats_;
+
+        TextLayoutCache() {}
+
+        static void layout(TextLayout& layout, ImFont* font, float font_size, const char* text, const char* text_end, float wrap_width);
+
+    public:
+        /**
+         * @brief Layout of the text in the current ImGui font, computed if it is not in the cache
+         * The reference stays valid until the next call
+         *
+         * @param wrap_width width at which lines are wrapped, no wrapping if <= 0
+         */
+        const TextLayout& get(const char* text, const char* text_end, float wrap_width);
+
+        void setCapacity(size_t entries);
+
+        void clear();
+
+        TextCacheStats getStats() const;
+
+        static TextLayoutCache& getInstance() {
+            static TextLayoutCache instance;
+            return instance;
+        }
+
+        // Copy constructors stay empty, because of the Singleton
+        TextLayoutCache(TextLayoutCache const&) = delete;
+        void operator=(TextLayoutCache const&) = delete;
+    };
+
+    /**
+     * @brief Same as ImGui::CalcTextSize, with the result cached (see TextLayoutCache)
+     *
+     * @param text UTF-8 text
+     * @param text_end end of the text, if nullptr the text must be null terminated
+     * @param wrap_width width at which lines are wrapped, no wrapping if <= 0
+     */
+    ImVec2 CalcTextSize(const char* text, const char* text_end = nullptr, float wrap_width = -1.f);
+
+    /**
+     * @brief Size and line breaks of the text in the current font, cached
+     * The reference stays valid until the next call to a function of the text cache
+     */
+    const TextLayout& CalcTextLayout(const char* text, const char* text_end = nullptr, float wrap_width = -1.f);
+
+    /**
+     * @brief Same as ImGui::TextUnformatted, the text is measured once and not drawn
+     * when it is clipped (e.g. cells of a large table)
+     */
+    void TextCached(const char* text, const char* text_end = nullptr);
+
+    /**
+     * @brief Same as ImGui::TextWrapped (without formatting), the line breaks are computed once
+     *
+     * @param wrap_width width at which lines are wrapped, if <= 0 the available width
+     */
+    void TextWrappedCached(const char* text, const char* text_end = nullptr, float wrap_width = 0.f);
+
+    /**
+     * @brief Sets the maximum number of texts in the cache (16384 by default)
+     */
+    void SetTextCacheCapacity(size_t entries);
+
+    TextCacheStats GetTextCacheStats();
+}
\ No newline at end of file
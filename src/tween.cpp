@@ -0,0 +1,186 @@
+#include "tween.h"
+
+#include <algorithm>
+
+namespace Tempo {
+    namespace {
+        // Used for the tweens without duration, which end at the next update
+        constexpr double max_inv_duration = 1e12;
+
+        inline float ease_in_quad(float t) { return t * t; }
+        inline float ease_out_quad(float t) { return t * (2.f - t); }
+        inline float ease_in_out_quad(float t) {
+            return t < 0.5f ? 2.f * t * t : -1.f + (4.f - 2.f * t) * t;
+        }
+        inline float ease_in_cubic(float t) { return t * t * t; }
+        inline float ease_out_cubic(float t) {
+            const float u = t - 1.f;
+            return u * u * u + 1.f;
+        }
+        inline float ease_in_out_cubic(float t) {
+            const float u = 2.f * t - 2.f;
+            return t < 0.5f ? 4.f * t * t * t : 0.5f * u * u * u + 1.f;
+        }
+        inline float ease_out_back(float t) {
+            constexpr float c1 = 1.70158f;
+            constexpr float c3 = c1 + 1.f;
+            const float u = t - 1.f;
+            return 1.f + c3 * u * u * u + c1 * u * u;
+        }
+
+        /*
+         * Eases the progress of the tweens using the easing, in a single pass without branches
+         */
+        template<typename F>
+        void ease_pass(const float* progress, const uint8_t* easing, float* eased, size_t count, uint8_t type, F function) {
+            for (size_t i = 0; i < count; i++) {
+                const float value = function(progress[i]);
+                eased[i] = easing[i] == type ? value : eased[i];
+            }
+        }
+    }
+
+    float ease(easingType easing, float t) {
+        t = std::clamp(t, 0.f, 1.f);
+        switch (easing) {
+        case EASING_IN_QUAD: return ease_in_quad(t);
+        case EASING_OUT_QUAD: return ease_out_quad(t);
+        case EASING_IN_OUT_QUAD: return ease_in_out_quad(t);
+        case EASING_IN_CUBIC: return ease_in_cubic(t);
+        case EASING_OUT_CUBIC: return ease_out_cubic(t);
+        case EASING_IN_OUT_CUBIC: return ease_in_out_cubic(t);
+        case EASING_OUT_BACK: return ease_out_back(t);
+        default: return t;
+        }
+    }
+
+    TweenHandle TweenEngine::start(float from, float to, double duration, easingType easing, double delay, TweenHandle reuse) {
+        if (easing < EASING_LINEAR || easing >= EASING_COUNT)
+            easing = EASING_LINEAR;
+
+        TweenHandle handle;
+        bool was_running = false;
+        if (owns(reuse)) {
+            handle = reuse;
+            was_running = isRunning(reuse);
+            easing_count_[easing_[handle.index]]--;
+        }
+        else if (!free_slots_.empty()) {
+            handle.index = free_slots_.back();
+            free_slots_.pop_back();
+            handle.generation = generation_[handle.index];
+        }
+        else {
+            handle.index = (uint32_t)generation_.size();
+            handle.generation = 0;
+            start_.push_back(0.);
+            end_.push_back(0.);
+            inv_duration_.push_back(0.);
+            from_.push_back(0.f);
+            to_.push_back(0.f);
+            progress_.push_back(0.f);
+            value_.push_back(0.f);
+            easing_.push_back(EASING_LINEAR);
+            generation_.push_back(0);
+            used_.push_back(0);
+        }
+
+        const uint32_t i = handle.index;
+        const double start = to_seconds(clock::now()) + std::max(delay, 0.);
+        start_[i] = start;
+        end_[i] = start + std::max(duration, 0.);
+        inv_duration_[i] = duration > 0. ? std::min(1. / duration, max_inv_duration) : max_inv_duration;
+        from_[i] = from;
+        to_[i] = to;
+        progress_[i] = 0.f;
+        value_[i] = from;
+        easing_[i] = (uint8_t)easing;
+        used_[i] = 1;
+        easing_count_[easing]++;
+
+        last_end_ = std::max(last_end_, end_[i]);
+        if (!was_running)
+            running_++;
+        return handle;
+    }
+
+    void TweenEngine::release(TweenHandle handle) {
+        if (!owns(handle))
+            return;
+        const uint32_t i = handle.index;
+        easing_count_[easing_[i]]--;
+        // The content of a free slot is unspecified: it is still updated with the
+        // other slots, but never read, and does not count as running
+        used_[i] = 0;
+        generation_[i]++;
+        free_slots_.push_back(i);
+    }
+
+    size_t TweenEngine::update(clock::time_point now) {
+        const size_t count = generation_.size();
+        const double now_s = to_seconds(now);
+        const double* start = start_.data();
+        const double* inv_duration = inv_duration_.data();
+        const double* end = end_.data();
+        const uint8_t* used = used_.data();
+        float* progress = progress_.data();
+
+        // Progress of all the tweens, and the ones still running
+        // (same criterion as isRunning: the update time is before the end)
+        size_t running = 0;
+        double last_end = 0.;
+        last_update_ = now_s;
+        for (size_t i = 0; i < count; i++) {
+            const double t = (now_s - start[i]) * inv_duration[i];
+            progress[i] = (float)std::clamp(t, 0., 1.);
+            const bool is_running = used[i] && now_s < end[i];
+            running += is_running;
+            last_end = std::max(last_end, is_running ? end[i] : 0.);
+        }
+        running_ = running;
+        last_end_ = last_end;
+
+        // Eased progress, in value_, one pass per easing in use
+        float* value = value_.data();
+        const uint8_t* easing = easing_.data();
+        std::copy(progress, progress + count, value);
+        if (easing_count_[EASING_IN_QUAD])
+            ease_pass(progress, easing, value, count, EASING_IN_QUAD, ease_in_quad);
+        if (easing_count_[EASING_OUT_QUAD])
+            ease_pass(progress, easing, value, count, EASING_OUT_QUAD, ease_out_quad);
+        if (easing_count_[EASING_IN_OUT_QUAD])
+            ease_pass(progress, easing, value, count, EASING_IN_OUT_QUAD, ease_in_out_quad);
+        if (easing_count_[EASING_IN_CUBIC])
+            ease_pass(progress, easing, value, count, EASING_IN_CUBIC, ease_in_cubic);
+        if (easing_count_[EASING_OUT_CUBIC])
+            ease_pass(progress, easing, value, count, EASING_OUT_CUBIC, ease_out_cubic);
+        if (easing_count_[EASING_IN_OUT_CUBIC])
+            ease_pass(progress, easing, value, count, EASING_IN_OUT_CUBIC, ease_in_out_cubic);
+        if (easing_count_[EASING_OUT_BACK])
+            ease_pass(progress, easing, value, count, EASING_OUT_BACK, ease_out_back);
+
+        // Interpolated values
+        const float* from = from_.data();
+        const float* to = to_.data();
+        for (size_t i = 0; i < count; i++) {
+            value[i] = from[i] + (to[i] - from[i]) * value[i];
+        }
+        return running;
+    }
+
+    TweenHandle StartTween(float from, float to, long long duration, easingType easing, long long delay, TweenHandle reuse) {
+        return TweenEngine::getInstance().start(from, to, (double)duration / 1000., easing, (double)delay / 1000., reuse);
+    }
+
+    float GetTweenValue(TweenHandle handle) {
+        return TweenEngine::getInstance().value(handle);
+    }
+
+    float GetTweenProgress(TweenHandle handle) {
+        return TweenEngine::getInstance().progress(handle);
+    }
+
+    void ReleaseTween(TweenHandle handle) {
+        TweenEngine::getInstance().release(handle);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tempo {
+    enum easingType {
+        EASING_LINEAR,
+        EASING_IN_QUAD,
+        EASING_OUT_QUAD,
+        EASING_IN_OUT_QUAD,
+        EASING_IN_CUBIC,
+        EASING_OUT_CUBIC,
+        EASING_IN_OUT_CUBIC,
+        EASING_OUT_BACK,     // Overshoots the end value, then comes back
+        EASING_COUNT
+    };
+
+    /**
+     * @brief Applies the easing curve to a progress
+     * @param t progress between 0 and 1
+     */
+    float ease(easingType easing, float t);
+
+    /**
+     * @brief Identifies a tween of the TweenEngine
+     * The handle becomes invalid once the tween is released, even if its slot is reused
+     */
+    struct TweenHandle {
+        static constexpr uint32_t invalid_index = 0xFFFFFFFF;
+        uint32_t index = invalid_index;
+        uint32_t generation = 0;
+
+        bool isValid() const { return index != invalid_index; }
+    };
+
+    /**
+     * @brief Interpolates values over time, with easing curves
+     *
+     * The tweens are stored as structure of arrays (one array per field), and are all
+     * updated by update() in a few passes over the arrays, which the compiler vectorizes.
+     * Values are read with the handle, without any lookup.
+     *
+     * A tween keeps its slot once finished (its value stays the end value), until it
+     * is released or restarted with its handle. The main loop renders continuously
+     * while a tween is running (see FramePacer).
+     *
+     * Must be used from the main thread
+     *
+     * @code{.cpp}
+     * static TweenHandle width;
+     * if (ImGui::IsItemHovered() != hovered) {
+     *     hovered = !hovered;
+     *     width = StartTween(GetTweenValue(width), hovered ? 200.f : 100.f, 250, EASING_OUT_CUBIC, 0, width);
+     * }
+     * ImGui::Button("Button", ImVec2(GetTweenValue(width), 0));
+     * @endcode
+     */
+    class TweenEngine {
+    public:
+        using clock = std::chrono::steady_clock;
+
+    private:
+        // Start times are relative to this point, in seconds
+        clock::time_point epoch_ = clock::now();
+
+        // Structure of arrays, indexed by TweenHandle::index
+        std::vector<double> start_;
+        std::vector<double> end_;
+        std::vector<double> inv_duration_;
+        std::vector<float> from_;
+        std::vector<float> to_;
+        std::vector<float> progress_;
+        std::vector<float> value_;
+        std::vector<uint8_t> easing_;
+        std::vector<uint32_t> generation_;
+        std::vector<uint8_t> used_;
+        std::vector<uint32_t> free_slots_;
+        // Number of tweens using each easing, only the easings in use are computed
+        size_t easing_count_[EASING_COUNT] = {};
+
+        // End of the last running tween, in seconds since the epoch
+        double last_end_ = 0.;
+        // Time of the last update, in seconds since the epoch
+        double last_update_ = 0.;
+        size_t running_ = 0;
+
+        TweenEngine() = default;
+
+        bool owns(TweenHandle handle) const {
+            return handle.index < generation_.size() && generation_[handle.index] == handle.generation
+                && used_[handle.index];
+        }
+
+        double to_seconds(clock::time_point time) const {
+            return std::chrono::duration<double>(time - epoch_).count();
+        }
+
+    public:
+        /**
+         * Copy constructors stay empty, because of the Singleton
+         */
+        TweenEngine(TweenEngine const&) = delete;
+        void operator=(TweenEngine const&) = delete;
+
+        /**
+         * @return instance of the Singleton of the TweenEngine
+         */
+        static TweenEngine& getInstance() {
+            static TweenEngine instance;
+            return instance;
+        }
+
+        /**
+         * @brief Starts a tween from now
+         *
+         * @param from value at the start
+         * @param to value at the end
+         * @param duration in seconds
+         * @param delay in seconds before the start (the value stays from until then)
+         * @param reuse if it is a valid handle, this tween is restarted instead of a new one
+         * @return handle of the tween
+         */
+        TweenHandle start(float from, float to, double duration, easingType easing = EASING_LINEAR, double delay = 0., TweenHandle reuse = TweenHandle{});
+
+        /**
+         * @brief Frees the slot of the tween, the handle becomes invalid
+         */
+        void release(TweenHandle handle);
+
+        /**
+         * @brief Updates the progress and value of all the tweens, called once per frame
+         * @return number of tweens still running
+         */
+        size_t update(clock::time_point now = clock::now());
+
+        /**
+         * @return eased value of the tween at the last update, 0 if the handle is invalid
+         */
+        float value(TweenHandle handle) const {
+            return owns(handle) ? value_[handle.index] : 0.f;
+        }
+
+        /**
+         * @return linear progress (0 to 1) of the tween at the last update, 1 if the handle is invalid
+         */
+        float progress(TweenHandle handle) const {
+            return owns(handle) ? progress_[handle.index] : 1.f;
+        }
+
+        /**
+         * @return true if the tween had not reached its end at the last update
+         * (or has been started since)
+         */
+        bool isRunning(TweenHandle handle) const {
+            return owns(handle) && last_update_ < end_[handle.index];
+        }
+
+        /**
+         * @return number of tweens running at the last update (same criterion as isRunning)
+         */
+        size_t running() const { return running_; }
+
+        /**
+         * @return time at which the last running tween ends
+         */
+        clock::time_point endTime() const {
+            return epoch_ + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(last_end_));
+        }
+
+        /**
+         * @return number of slots in use (running or finished tweens not released)
+         */
+        size_t size() const { return generation_.size() - free_slots_.size(); }
+    };
+
+    /**
+     * @brief Starts a tween (see TweenEngine::start), durations in ms
+     */
+    TweenHandle StartTween(float from, float to, long long duration, easingType easing = EASING_LINEAR, long long delay = 0, TweenHandle reuse = TweenHandle{});
+
+    /**
+     * @return eased value of the tween, 0 if the handle is invalid
+     */
+    float GetTweenValue(TweenHandle handle);
+
+    /**
+     * @return linear progress (0 to 1) of the tween, 1 if the handle is invalid
+     */
+    float GetTweenProgress(TweenHandle handle);
+
+    /**
+     * @brief Releases the tween, the handle becomes invalid
+     */
+    void ReleaseTween(TweenHandle handle);
+}
\ No newline at end of file
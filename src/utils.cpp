@@ -1,6 +1,10 @@
 #include "utils.h"
 
 #include "tempo.h"
+#include "frame_fingerprint.h"
+#include "frame_pacer.h"
+#include "damage.h"
+#include "text/fonts_private.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_glfw.h"
 
@@ -29,6 +33,9 @@ namespace Tempo {
     std::string nameToAppConfigFile(const std::string& name) {
         return "cfg_" + strToPathFriendly(name) + ".toml";
     }
+    std::string nameToFontCacheFile(const std::string& name) {
+        return "cache_fonts_" + strToPathFriendly(name) + ".bin";
+    }
 
     // Adapted from https://stackoverflow.com/a/31526753
     GLFWmonitor* getCurrentMonitor(GLFWwindow* window) {
@@ -72,26 +79,71 @@ namespace Tempo {
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
+        // Characters typed by the user are rasterized in the dynamic fonts
+        // (the input queue is filled by NewFrame and cleared at the end of the frame)
+        for (ImWchar c : io.InputQueueCharacters) {
+            if (FONTM.glyph_cache.request(c))
+                FONTM.glyphsMissing();
+        }
         if (application != nullptr)
             application->FrameUpdate();
+        // Input keeps the loop rendering at the target frame rate
+        FramePacer::getInstance().updateActivity();
+        if (app_state.show_latency_overlay)
+            ShowInputLatencyOverlay();
         ImGui::Render();
+        auto& latency_tracker = InputLatencyTracker::getInstance();
+        latency_tracker.endStage(LATENCY_STAGE_FRAME_UPDATE);
 
-        // int width, display_h;
-        // glfwGetFramebufferSize(window, &width, &height);
-        glViewport(0, 0, width, height);
-        glClearColor(0.5, 0.5, 0.5, 0);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
-            GLFWwindow* backup_current_context = glfwGetCurrentContext();
+        const bool viewports = io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable;
+        GLFWwindow* backup_current_context = glfwGetCurrentContext();
+        if (viewports) {
+            // The platform windows are created, moved and resized before the frame is compared
             ImGui::UpdatePlatformWindows();
-            ImGui::RenderPlatformWindowsDefault();
             glfwMakeContextCurrent(backup_current_context);
         }
 
-        if (!app_state.skip_frame)
+        // Frames identical to the last presented one are neither drawn nor swapped
+        bool render = true;
+        FrameFingerprint& fingerprint = FrameFingerprint::getInstance();
+        if (app_state.skip_identical_frames) {
+            // Font textures are recreated when the atlas changes, and can get the same id
+            uint64_t seed = FONTM.atlas_generation ^ ((uint64_t)width << 32 | (uint32_t)height);
+            render = fingerprint.update(FrameFingerprint::computeFrame(seed));
+        }
+
+        if (render) {
+            // Only the regions that changed are drawn again, in a persistent framebuffer
+            const bool drawn = app_state.damage_tracking
+                && DamageTracker::getInstance().render(ImGui::GetDrawData(), width, height, FONTM.atlas_generation);
+            if (!drawn) {
+                // int width, display_h;
+                // glfwGetFramebufferSize(window, &width, &height);
+                glViewport(0, 0, width, height);
+                glClearColor(0.5, 0.5, 0.5, 0);
+                glClear(GL_COLOR_BUFFER_BIT);
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
+
+            if (viewports) {
+                ImGui::RenderPlatformWindowsDefault();
+                glfwMakeContextCurrent(backup_current_context);
+            }
+        }
+
+        latency_tracker.endStage(LATENCY_STAGE_RENDER);
+        if (render && !app_state.skip_frame) {
             glfwSwapBuffers(window);
+            latency_tracker.endStage(LATENCY_STAGE_PRESENT);
+        }
+        else {
+            // The input is measured when a frame is actually presented
+            latency_tracker.skipPresent();
+            FramePacer::getInstance().frameSkipped();
+        }
+        // The frame has not been presented, the next one must be
+        if (app_state.skip_frame)
+            fingerprint.invalidate();
         app_state.skip_frame = false;
     }
 }
\ No newline at end of file
@@ -8,6 +8,7 @@ namespace Tempo {
 
     std::string strToPathFriendly(const std::string& str);
     std::string nameToAppConfigFile(const std::string& name);
+    std::string nameToFontCacheFile(const std::string& name);
 
     GLFWmonitor* getCurrentMonitor(GLFWwindow* window);
 